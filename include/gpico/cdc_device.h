@@ -6,61 +6,270 @@
 #define GPICO_CDC_H_
 
 #include <gpico/io_device.h>
+#include <gpico/lock.h>
+
+#include <FreeRTOS.h>
+#include <event_groups.h>
+#include <stream_buffer.h>
 
 #include <atomic>
+#include <array>
+#include <cstdint>
 #include <span>
 #include <expected>
 
+#ifndef GPICO_CDC_TX_BUFFER_SIZE
+#define GPICO_CDC_TX_BUFFER_SIZE 1024
+#endif
+
 namespace gpico
 {
 
+class cdc_device;
+
+/** File descriptor representing a CDC device.
+ */
+class cdc_file_descriptor : public file_descriptor
+{
+public:
+	/** Constructor.
+	 *
+	 * @param[in,out] device CDC device to associate with this descriptor.
+	 */
+	cdc_file_descriptor(cdc_device& device);
+
+	int write(std::span<const std::byte> data) override;
+
+	int read(std::span<std::byte> buffer) override;
+
+	int writev(std::span<const std::span<const std::byte>> buffers) override;
+
+	int readv(std::span<const std::span<std::byte>> buffers) override;
+
+	uint8_t poll_ready() override;
+
+	EventBits_t poll_bit() override;
+private:
+	cdc_device& device;
+};
+
+/** Rules for when data written to a CDC device is sent to the host.
+ *
+ * Full USB packets are always sent as soon as they are available. These
+ * rules control when a partial packet is sent.
+ */
+struct cdc_flush_policy
+{
+	/// Send pending data as soon as a newline is written.
+	bool newline = true;
+	/// Send pending data once at least this many bytes are waiting.
+	size_t threshold = 64;
+	/// Send pending data once it has been waiting for this many ticks.
+	TickType_t max_delay = pdMS_TO_TICKS(10);
+};
+
 /** IO device representing a TinyUSB CDC serial connection.
+ *
+ * Each object drives one CDC interface of the composite USB device, with its
+ * own buffers, so e.g. bulk data on one interface does not hold up a console
+ * on another. The application's TinyUSB configuration (CFG_TUD_CDC) and
+ * descriptors determine how many interfaces there are. Interface 0 is always
+ * available as gpico::cdc, and is the one used for stdin, stdout, and stderr.
+ *
+ * Objects should have static storage duration, as the USB task services
+ * every CDC device constructed.
  */
 class cdc_device : public io_device
 {
 public:
+	/** Event group bits set by the USB task for each CDC device.
+	 */
+	enum event : EventBits_t
+	{
+		/// Set when the device has received data, or its connection state
+		/// changed. Waiters are expected to clear it before checking for
+		/// data.
+		event_rx = 1 << 0,
+		/// Set while the device is connected to a host.
+		event_connected = 1 << 1,
+	};
+
+	/** Constructor.
+	 *
+	 * @param[in] interface Number of the CDC interface to drive, must be
+	 *  less than CFG_TUD_CDC, and unique.
+	 */
+	explicit cdc_device(uint8_t interface = 0);
+
+	cdc_device(const cdc_device&) = delete;
+	cdc_device& operator=(const cdc_device&) = delete;
+
+	/** Waits until the CDC device is connected to a host.
+	 *
+	 * This blocks the calling task without using the CPU.
+	 *
+	 * @returns True once connected.
+	 */
 	bool probe() override;
 
 	bool unload() override;
 
 	std::expected<file_descriptor*, int> open(const char *path) override;
 
-	/** Sends data over the CDC device.
+	/** Returns the number of the CDC interface this device drives.
+	 */
+	uint8_t interface() const;
+
+	/** Returns whether the CDC device is connected to a host or not.
+	 */
+	bool connected() const;
+
+	/** Returns the event group used to signal events for this device.
+	 *
+	 * @see event
+	 */
+	EventGroupHandle_t events() const;
+
+	/** Queues data to be sent over the CDC device.
+	 *
+	 * The data is copied into a transmit buffer, which the USB task drains
+	 * in full packets where possible. This blocks until all of the data is
+	 * queued, unless the host disconnects while waiting for space.
 	 *
 	 * @param[in] data Data to send.
 	 *
-	 * @returns The number of bytes sent, or -1 if an error occurred. On an
+	 * @returns The number of bytes queued, or -1 if an error occurred. On an
 	 *  error errno is set.
+	 *
+	 * @see set_flush_policy
 	 */
 	int write(std::span<const std::byte> data);
 
+	/** Queues the data in the given buffers to be sent, in order.
+	 *
+	 * The data of all buffers is queued without data from other writers in
+	 * between, and is flushed as a whole according to the flush policy.
+	 *
+	 * @param[in] buffers Buffers with the data to send.
+	 *
+	 * @returns The total number of bytes queued, or -1 if an error occurred.
+	 *  On an error errno is set.
+	 */
+	int writev(std::span<const std::span<const std::byte>> buffers);
+
+	/** Returns the number of bytes that can be queued without blocking.
+	 *
+	 * Only grows until the next write, as the USB task drains the buffer.
+	 */
+	size_t write_available() const;
+
+	/** Asks the USB task to send any pending data, even if it does not fill
+	 *  a packet.
+	 */
+	void flush();
+
+	/** Sets when pending data that does not fill a packet is sent.
+	 *
+	 * @param[in] policy New flush policy.
+	 */
+	void set_flush_policy(const cdc_flush_policy& policy);
+
 	/** Receives data over the CDC device.
+	 *
+	 * Blocks, without using the CPU, until there is data available or the
+	 * read timeout expires.
 	 *
 	 * @param[in] data Buffer for incoming data.
 	 *
 	 * @returns The number of bytes received, or -1 if an error occurred. On an
-	 *  error errno is set.
+	 *  error errno is set, to EAGAIN if the timeout expired.
+	 *
+	 * @see set_read_timeout
 	 */
-
 	int read(std::span<std::byte> buffer);
-};
 
-/** File descriptor representing a CDC device.
- */
-class cdc_file_descriptor : public file_descriptor
-{
-public:
-	/** Constructor.
+	/** Receives data over the CDC device, with the given timeout.
 	 *
-	 * @param[in,out] device CDC device to associate with this descriptor.
+	 * @param[in] data Buffer for incoming data.
+	 * @param[in] timeout Maximum time to wait for data, in ticks. 0 makes
+	 *  the read non-blocking, and portMAX_DELAY waits forever.
+	 *
+	 * @returns The number of bytes received, or -1 if an error occurred. On an
+	 *  error errno is set, to EAGAIN if the timeout expired.
 	 */
-	cdc_file_descriptor(cdc_device& device);
+	int read(std::span<std::byte> buffer, TickType_t timeout);
 
-	int write(std::span<const std::byte> data) override;
+	/** Sets the timeout used by read calls without an explicit timeout.
+	 *
+	 * This also applies to reads through file descriptors, such as stdin.
+	 *
+	 * @param[in] timeout Timeout in ticks. 0 makes reads non-blocking, and
+	 *  portMAX_DELAY (the default) waits forever.
+	 */
+	void set_read_timeout(TickType_t timeout);
+
+	/** Receives data over the CDC device into the given buffers, in order.
+	 *
+	 * Blocks, like read(), only until some data is available, then fills the
+	 * buffers with whatever data is there.
+	 *
+	 * @param[in] buffers Buffers for incoming data.
+	 *
+	 * @returns The total number of bytes received, or -1 if an error
+	 *  occurred. On an error errno is set.
+	 */
+	int readv(std::span<const std::span<std::byte>> buffers);
+
+	/** Returns the current readiness of the device, as poll_event flags.
+	 *
+	 * @see gpico::poll
+	 */
+	uint8_t poll_ready();
+
+	/** Returns the bit of the poll_events() event group signaling readiness
+	 *  changes of this device.
+	 */
+	EventBits_t poll_bit() const;
+
+	/** Services every CDC device: tracks connection state, signals received
+	 *  data, and moves queued data into the USB stack according to each flush
+	 *  policy.
+	 *
+	 * This must only be called from the USB task, around tud_task.
+	 *
+	 * @returns The number of ticks until this needs to be called again to
+	 *  honor the flush policies, or portMAX_DELAY if only new USB events or
+	 *  writes require it to be called again.
+	 */
+	static TickType_t process_all();
 
-	int read(std::span<std::byte> buffer) override;
 private:
-	cdc_device& device;
+	uint8_t interface_;
+	std::atomic_bool connected_ = false;
+	std::atomic<TickType_t> read_timeout_ = portMAX_DELAY;
+	StaticEventGroup_t events_buffer_;
+	EventGroupHandle_t events_;
+	EventBits_t poll_bit_;
+	cdc_file_descriptor descriptor_;
+
+	// Transmit buffer, with the lock serializing writers, as stream buffers
+	// only support one writer at a time
+	mutex write_lock_;
+	std::array<uint8_t, GPICO_CDC_TX_BUFFER_SIZE + 1> tx_storage_;
+	StaticStreamBuffer_t tx_buffer_;
+	StreamBufferHandle_t tx_;
+
+	std::atomic_bool flush_on_newline_ = true;
+	std::atomic<size_t> flush_threshold_ = 64;
+	std::atomic<TickType_t> flush_delay_ = pdMS_TO_TICKS(10);
+	std::atomic_bool flush_requested_ = false;
+
+	// Only used by the USB task
+	bool tx_pending_ = false;
+	TickType_t tx_pending_since_ = 0;
+
+	TickType_t process();
+	TickType_t process_tx();
 };
 
 extern cdc_device cdc;
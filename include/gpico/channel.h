@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_CHANNEL_H_
+#define GPICO_CHANNEL_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <utility>
+
+#ifndef GPICO_CHANNEL_NOTIFY_INDEX
+#define GPICO_CHANNEL_NOTIFY_INDEX 0
+#endif
+
+namespace gpico
+{
+
+/// Index of the task notification that wakes up tasks waiting on channels.
+constexpr UBaseType_t channel_notify_index = GPICO_CHANNEL_NOTIFY_INDEX;
+static_assert(channel_notify_index < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+	"GPICO_CHANNEL_NOTIFY_INDEX must be less than configTASK_NOTIFICATION_ARRAY_ENTRIES");
+
+/** Single-producer, single-consumer channel, meant for passing messages
+ *  between tasks on different cores.
+ *
+ * Messages live in a lock-free ring of slots inside the channel, so sending
+ * and receiving without waiting never takes a kernel lock, and can be done
+ * from interrupt handlers. A task that waits for a slot or a message sleeps
+ * on a task notification, which the other side gives only if it is waiting;
+ * FreeRTOS delivers it to the other core through the SIO FIFO interrupt.
+ *
+ * Besides send() and receive(), which move messages in and out, the slot
+ * API (prepare() and commit() to send, peek() and release() to receive)
+ * lets both sides work on messages in place, so large buffers are never
+ * copied. Pointers to buffers owned elsewhere can also be sent as messages.
+ *
+ * Only one task (or interrupt handler) may send, and only one may receive,
+ * at a time. A task waiting on the channel is notified at
+ * channel_notify_index, so it must not use that notification for anything
+ * else, and it must not be deleted while the other side may still use the
+ * channel.
+ *
+ * @tparam T Type of the messages, default constructible and movable. Slots
+ *  are constructed with the channel and reused, so they keep the state left
+ *  in them.
+ * @tparam Capacity Number of slots, a power of 2.
+ */
+template<class T, size_t Capacity>
+class channel
+{
+public:
+	static_assert(Capacity && (Capacity & (Capacity - 1)) == 0,
+		"Channel capacity must be a power of 2");
+
+	/// Number of messages the channel can hold.
+	static constexpr size_t capacity = Capacity;
+
+	channel() = default;
+
+	channel(const channel&) = delete;
+	channel& operator=(const channel&) = delete;
+
+	/** Returns the next free slot, for the producer to fill in place.
+	 *
+	 * Returns the same slot until it is committed.
+	 *
+	 * @param[in] timeout Maximum time to wait for a free slot, in ticks. 0
+	 *  never blocks, and portMAX_DELAY waits forever.
+	 *
+	 * @returns The slot, or null if the timeout expired.
+	 */
+	T *prepare(TickType_t timeout = portMAX_DELAY)
+	{
+		const uint32_t tail = tail_.load(std::memory_order_relaxed);
+		auto free = [this, tail] {
+			return tail - head_.load(std::memory_order_seq_cst) < Capacity;
+		};
+		if (!free() && !wait(producer_, free, timeout))
+			return nullptr;
+		return &slots_[tail % Capacity];
+	}
+
+	/** Sends the slot returned by prepare() to the consumer.
+	 */
+	void commit()
+	{
+		tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+		ring(consumer_);
+	}
+
+	/** Moves a message into the channel.
+	 *
+	 * @param[in] message Message to send.
+	 * @param[in] timeout Maximum time to wait for a free slot, in ticks. 0
+	 *  never blocks, and portMAX_DELAY waits forever.
+	 *
+	 * @returns True if the message was sent, false if the timeout expired.
+	 */
+	bool send(T message, TickType_t timeout = portMAX_DELAY)
+	{
+		T *slot = prepare(timeout);
+		if (!slot)
+			return false;
+		*slot = std::move(message);
+		commit();
+		return true;
+	}
+
+	/** Returns the oldest message, for the consumer to use in place.
+	 *
+	 * Returns the same message until it is released.
+	 *
+	 * @param[in] timeout Maximum time to wait for a message, in ticks. 0
+	 *  never blocks, and portMAX_DELAY waits forever.
+	 *
+	 * @returns The message, or null if the timeout expired.
+	 */
+	T *peek(TickType_t timeout = portMAX_DELAY)
+	{
+		const uint32_t head = head_.load(std::memory_order_relaxed);
+		auto ready = [this, head] {
+			return tail_.load(std::memory_order_seq_cst) != head;
+		};
+		if (!ready() && !wait(consumer_, ready, timeout))
+			return nullptr;
+		return &slots_[head % Capacity];
+	}
+
+	/** Gives the slot of the message returned by peek() back to the
+	 *  producer.
+	 */
+	void release()
+	{
+		head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+		ring(producer_);
+	}
+
+	/** Moves the oldest message out of the channel.
+	 *
+	 * @param[in] timeout Maximum time to wait for a message, in ticks. 0
+	 *  never blocks, and portMAX_DELAY waits forever.
+	 *
+	 * @returns The message, or EAGAIN if the timeout expired.
+	 */
+	std::expected<T, int> receive(TickType_t timeout = portMAX_DELAY)
+	{
+		T *slot = peek(timeout);
+		if (!slot)
+			return std::unexpected(EAGAIN);
+		T result = std::move(*slot);
+		release();
+		return result;
+	}
+
+	/** Returns the number of messages in the channel.
+	 *
+	 * Only a snapshot, as the other side may change it at any time.
+	 */
+	size_t size() const
+	{
+		return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+	}
+
+	/** Returns whether the channel has no messages, as a snapshot.
+	 */
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+private:
+	std::array<T, Capacity> slots_ = {};
+	// Free running, so all slots can be used, and only written by the
+	// consumer and producer respectively
+	std::atomic<uint32_t> head_ = 0;
+	std::atomic<uint32_t> tail_ = 0;
+	// Task waiting on each side, if any
+	std::atomic<TaskHandle_t> producer_ = nullptr;
+	std::atomic<TaskHandle_t> consumer_ = nullptr;
+
+	// Lets the host tests start the indices close to wrapping around
+	friend struct channel_test_access;
+
+	// Blocks until ready() returns true, returns false on timeout. The
+	// waiting task is published before checking ready() again, and the
+	// other side updates the ring before checking for a waiting task, both
+	// sequentially consistent, so either this sees the update or the other
+	// side sees the task and notifies it
+	template<class Ready>
+	static bool wait(std::atomic<TaskHandle_t>& waiter, Ready ready, TickType_t timeout)
+	{
+		if (!timeout)
+			return false;
+
+		TimeOut_t start;
+		vTaskSetTimeOutState(&start);
+		bool result;
+		waiter.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+		// Notifications may be left over from earlier waits, so they only
+		// mean something may have changed
+		while (!(result = ready()) && !xTaskCheckForTimeOut(&start, &timeout))
+			ulTaskNotifyTakeIndexed(channel_notify_index, pdTRUE, timeout);
+		waiter.store(nullptr, std::memory_order_relaxed);
+		return result;
+	}
+
+	static void ring(std::atomic<TaskHandle_t>& waiter)
+	{
+		TaskHandle_t task = waiter.load(std::memory_order_seq_cst);
+		if (!task)
+			return;
+
+		if (portCHECK_IF_IN_ISR())
+		{
+			BaseType_t woken = pdFALSE;
+			vTaskNotifyGiveIndexedFromISR(task, channel_notify_index, &woken);
+			portYIELD_FROM_ISR(woken);
+		}
+		else
+		{
+			xTaskNotifyGiveIndexed(task, channel_notify_index);
+		}
+	}
+};
+
+}
+
+#endif//GPICO_CHANNEL_H_
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_COBS_H_
+#define GPICO_COBS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/** Consistent Overhead Byte Stuffing (COBS) framing.
+ *
+ * COBS encodes data so that it contains no zero bytes, at a cost of at most
+ * one byte per 254 bytes of data, so a zero byte can delimit frames on a byte
+ * stream. A receiver that loses track of the stream resynchronizes at the next
+ * zero byte.
+ */
+namespace gpico::cobs
+{
+	/** Returns the largest size the given amount of data can take once
+	 *  encoded, not including the frame delimiter.
+	 */
+	constexpr size_t max_encoded_size(size_t size)
+	{
+		return size + size / 254 + 1;
+	}
+
+	/** Encodes data made of several discontiguous parts, without copying it.
+	 *
+	 * The encoded data is handed to the sink as a sequence of spans, which
+	 * are either single code bytes or subspans of the input parts. The frame
+	 * delimiter is not included.
+	 *
+	 * @tparam Sink Callable taking a std::span<const std::byte>.
+	 *
+	 * @param[in] parts Data to encode, in order.
+	 * @param[in,out] sink Receiver of the encoded data.
+	 */
+	template<class Sink>
+	void encode(std::span<const std::span<const std::byte>> parts, Sink&& sink)
+	{
+		size_t part = 0;
+		size_t offset = 0;
+		for (;;)
+		{
+			// Measure the next block, up to 254 non-zero bytes
+			size_t run = 0;
+			size_t p = part;
+			size_t o = offset;
+			bool zero = false;
+			while (run < 254 && p < parts.size())
+			{
+				if (o == parts[p].size())
+				{
+					++p;
+					o = 0;
+				}
+				else if (parts[p][o] == std::byte{0})
+				{
+					zero = true;
+					break;
+				}
+				else
+				{
+					++o;
+					++run;
+				}
+			}
+
+			const std::byte code{static_cast<uint8_t>(run + 1)};
+			sink(std::span<const std::byte>(&code, 1));
+			for (size_t left = run; left;)
+			{
+				if (offset == parts[part].size())
+				{
+					++part;
+					offset = 0;
+					continue;
+				}
+				size_t count = std::min(left, parts[part].size() - offset);
+				sink(parts[part].subspan(offset, count));
+				offset += count;
+				left -= count;
+			}
+
+			if (zero)
+			{
+				// The zero is implied by the code byte
+				part = p;
+				offset = o + 1;
+				continue;
+			}
+
+			// Skip over exhausted parts to tell whether there is more data
+			while (part < parts.size() && offset == parts[part].size())
+			{
+				++part;
+				offset = 0;
+			}
+			if (part == parts.size())
+				break;
+		}
+	}
+
+	/** Incremental COBS decoder.
+	 *
+	 * Bytes received from a stream are fed one at a time, and decoded frames
+	 * are reported when their delimiter arrives. Frames that do not fit in the
+	 * buffer, or that are malformed, are discarded.
+	 */
+	class decoder
+	{
+	public:
+		/** Result of feeding a byte to the decoder.
+		 */
+		enum class status
+		{
+			/// More data is needed to complete the frame.
+			incomplete,
+			/// A frame was completed, and is available through frame().
+			complete,
+			/// A frame was discarded, as it was too large or malformed.
+			error,
+		};
+
+		/** Constructor.
+		 *
+		 * @param[in] buffer Storage for the decoded frame. Must outlive the
+		 *  decoder.
+		 */
+		explicit decoder(std::span<std::byte> buffer)
+		:buffer_(buffer)
+		{}
+
+		/** Feeds a byte received from the stream.
+		 *
+		 * @param[in] byte Next byte of the stream.
+		 *
+		 * @returns The status of the frame being decoded.
+		 */
+		status put(std::byte byte)
+		{
+			if (byte == std::byte{0})
+			{
+				const bool started = code_ != 0;
+				const bool valid = !error_ && remaining_ == 0;
+				frame_size_ = size_;
+				reset();
+				if (!started)
+					return status::incomplete;
+				if (!valid)
+				{
+					frame_size_ = 0;
+					return status::error;
+				}
+				return status::complete;
+			}
+
+			if (remaining_ == 0)
+			{
+				// New block; the previous one implies a zero unless it was
+				// full
+				if (code_ != 0 && code_ != 0xFF)
+					append(std::byte{0});
+				code_ = static_cast<uint8_t>(byte);
+				remaining_ = code_ - 1;
+			}
+			else
+			{
+				append(byte);
+				--remaining_;
+			}
+			return status::incomplete;
+		}
+
+		/** Returns the last frame completed.
+		 *
+		 * This is only valid right after put() returns status::complete, until
+		 * the next byte is fed.
+		 */
+		std::span<const std::byte> frame() const
+		{
+			return buffer_.first(frame_size_);
+		}
+
+		/** Discards the frame being decoded.
+		 */
+		void reset()
+		{
+			size_ = 0;
+			code_ = 0;
+			remaining_ = 0;
+			error_ = false;
+		}
+
+	private:
+		std::span<std::byte> buffer_;
+		size_t size_ = 0;
+		size_t frame_size_ = 0;
+		uint8_t code_ = 0;
+		uint8_t remaining_ = 0;
+		bool error_ = false;
+
+		void append(std::byte byte)
+		{
+			if (size_ < buffer_.size())
+				buffer_[size_++] = byte;
+			else
+				error_ = true;
+		}
+	};
+}
+
+#endif//GPICO_COBS_H_
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_CPU_LOAD_H_
+#define GPICO_CPU_LOAD_H_
+
+#include <gpico/lock.h>
+#include <gpico/static_task.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#ifndef GPICO_CPU_LOAD_MAX_TASKS
+#define GPICO_CPU_LOAD_MAX_TASKS 24
+#endif
+
+#ifndef GPICO_CPU_LOAD_HISTORY
+#define GPICO_CPU_LOAD_HISTORY 16
+#endif
+
+namespace gpico
+{
+
+/** Returns the time core has spent running tasks other than the idle tasks,
+ *  in microseconds.
+ *
+ * Requires the hooks in gpico/freertos_hooks.h. The value wraps around, so
+ * only differences between calls less than ~71 minutes apart are meaningful.
+ *
+ * @param[in] core Core to query.
+ */
+uint32_t core_busy_time(unsigned core);
+
+/** Load of a task over a window, as returned by cpu_load::tasks().
+ */
+struct task_load
+{
+	/// Task handle.
+	TaskHandle_t task;
+	/// Task name.
+	std::array<char, configMAX_TASK_NAME_LEN> name;
+	/// Cores the task may run on.
+	UBaseType_t affinity;
+	/// Share of one core's time the task ran for, in tenths of a percent.
+	uint16_t load;
+};
+
+/** Sampler of the CPU load of each core and each task, over sliding windows.
+ *
+ * A task of the sampler records the busy time of each core and the FreeRTOS
+ * run-time counter of each task every period, keeping the last
+ * GPICO_CPU_LOAD_HISTORY samples. Loads can be queried over any window of up
+ * to that many of the latest samples.
+ *
+ * Requires configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY, and
+ * the hooks in gpico/freertos_hooks.h. FreeRTOS only updates the run-time
+ * counter of a task when it is switched out, so a task that runs for a whole
+ * period without being preempted is accounted for in the next one. Core loads
+ * include the time still running at each sample, so they do not lag.
+ *
+ * While there are more than max_tasks tasks, FreeRTOS reports none of them,
+ * so per-task loads stop being collected: the tracked tasks count as idle
+ * for those samples, and an error is logged to sys_log. Core loads are not
+ * affected.
+ */
+class cpu_load
+{
+public:
+	/// Largest number of tasks that are tracked.
+	static constexpr size_t max_tasks = GPICO_CPU_LOAD_MAX_TASKS;
+	/// Number of samples kept, and so the largest window.
+	static constexpr size_t history = GPICO_CPU_LOAD_HISTORY;
+
+	cpu_load() = default;
+
+	cpu_load(const cpu_load&) = delete;
+	cpu_load& operator=(const cpu_load&) = delete;
+
+	/** Starts the sampler task.
+	 *
+	 * Must be called once.
+	 *
+	 * @param[in] period Time between samples. Must be under ~71 minutes.
+	 * @param[in] priority Priority of the sampler task. It should be higher
+	 *  than the tasks being measured, so samples are taken on time.
+	 * @param[in] log_every Number of samples between reports of the loads to
+	 *  sys_log, each over the window of the samples since the previous one
+	 *  (up to history). 0 disables the reports.
+	 */
+	void start(TickType_t period, UBaseType_t priority, size_t log_every = 0);
+
+	/** Returns the load of a core over the latest samples.
+	 *
+	 * @param[in] core Core to query.
+	 * @param[in] window Number of samples to cover. If fewer have been taken,
+	 *  covers all of them.
+	 *
+	 * @returns The share of the time the core was busy, in tenths of a
+	 *  percent, EINVAL if core or window are out of range, or EAGAIN if no
+	 *  samples have been taken yet.
+	 */
+	std::expected<uint16_t, int> core(unsigned core, size_t window) const;
+
+	/** Returns the load of each task over the latest samples.
+	 *
+	 * @param[out] loads Where to write the load of each tracked task.
+	 * @param[in] window Number of samples to cover. If fewer have been taken,
+	 *  covers all of them.
+	 *
+	 * @returns The number of entries written, EINVAL if window is out of
+	 *  range, or EAGAIN if no samples have been taken yet.
+	 */
+	std::expected<size_t, int> tasks(std::span<task_load> loads, size_t window) const;
+
+private:
+	struct tracked_task
+	{
+		TaskHandle_t task;
+		std::array<char, configMAX_TASK_NAME_LEN> name;
+		UBaseType_t affinity;
+		configRUN_TIME_COUNTER_TYPE last;
+		std::array<uint32_t, history> run_time;
+	};
+
+	mutable mutex lock_;
+	// Samples are stored in rings, the latest one at index head_
+	size_t head_ = 0;
+	size_t samples_ = 0;
+	std::array<uint32_t, history> elapsed_ = {};
+	std::array<std::array<uint32_t, history>, configNUMBER_OF_CORES> busy_ = {};
+	std::array<tracked_task, max_tasks> tasks_ = {};
+	size_t task_count_ = 0;
+
+	// Only used by the sampler task
+	std::array<TaskStatus_t, max_tasks> status_;
+	uint32_t last_time_ = 0;
+	bool over_limit_ = false;
+	std::array<uint32_t, configNUMBER_OF_CORES> last_busy_ = {};
+	TickType_t period_ = 0;
+	size_t log_every_ = 0;
+
+	static_task<384> task_;
+
+	void sample(bool record);
+	void report(size_t window) const;
+	uint64_t window_sum(const std::array<uint32_t, history>& ring, size_t window) const;
+	size_t clamp_window(size_t window) const;
+
+	static void sampler(void *param);
+};
+
+}
+
+#endif//GPICO_CPU_LOAD_H_
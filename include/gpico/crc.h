@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_CRC_H_
+#define GPICO_CRC_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace gpico
+{
+	namespace detail
+	{
+		constexpr std::array<uint32_t, 256> make_crc32_table()
+		{
+			std::array<uint32_t, 256> table{};
+			for (uint32_t i = 0; i < table.size(); ++i)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; ++bit)
+					crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB8'8320u : 0u);
+				table[i] = crc;
+			}
+			return table;
+		}
+
+		inline constexpr std::array<uint32_t, 256> crc32_table =
+			make_crc32_table();
+	}
+
+	/** Computes the CRC-32 (IEEE 802.3, as used by zlib) of the given data.
+	 *
+	 * The CRC can be computed incrementally by passing the result of the
+	 * previous call as the crc argument.
+	 *
+	 * @param[in] data Data to compute the CRC of.
+	 * @param[in] crc CRC of the data preceding this data, 0 for the start.
+	 *
+	 * @returns The CRC of all of the data so far.
+	 */
+	constexpr uint32_t crc32(std::span<const std::byte> data, uint32_t crc = 0)
+	{
+		crc = ~crc;
+		for (std::byte byte : data)
+			crc = detail::crc32_table[(crc ^ static_cast<uint8_t>(byte)) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	/** Computes the CRC-32 of the object representation of a value.
+	 *
+	 * The type must not have padding, or the CRC depends on the padding
+	 * contents.
+	 *
+	 * @param[in] value Value to compute the CRC of.
+	 * @param[in] crc CRC of the data preceding this data, 0 for the start.
+	 *
+	 * @returns The CRC of all of the data so far.
+	 */
+	template<class T>
+		requires (std::is_trivially_copyable_v<T> &&
+			!std::is_convertible_v<const T&, std::span<const std::byte>>)
+	uint32_t crc32(const T& value, uint32_t crc = 0)
+	{
+		return crc32(std::as_bytes(std::span<const T, 1>(&value, 1)), crc);
+	}
+}
+
+#endif//GPICO_CRC_H_
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_ENTROPY_H_
+#define GPICO_ENTROPY_H_
+
+#include <cstddef>
+#include <span>
+
+namespace gpico
+{
+	/** Fills the buffer with cryptographically secure random bytes.
+	 *
+	 * The bytes come from a ChaCha20 based DRBG with fast key erasure: every
+	 * request replaces the key, so earlier output cannot be recovered from
+	 * the state. The DRBG is seeded from pico_rand, and mixes in fresh
+	 * pico_rand output periodically, by amount of data and by time.
+	 *
+	 * This is safe to call from tasks on both cores, and before the scheduler
+	 * starts, but not from interrupt handlers.
+	 *
+	 * @param[out] buffer Buffer to fill, of any size.
+	 */
+	void get_entropy(std::span<std::byte> buffer);
+
+	/** Mixes fresh pico_rand output into the DRBG state right away.
+	 */
+	void reseed_entropy();
+}
+
+#endif//GPICO_ENTROPY_H_
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_FILE_SERVICE_H_
+#define GPICO_FILE_SERVICE_H_
+
+#include <gpico/flash.h>
+#include <gpico/rpc.h>
+#include <gpico/static_task.h>
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#ifndef GPICO_FILE_CHUNK_SIZE
+#define GPICO_FILE_CHUNK_SIZE 1024
+#endif
+
+namespace gpico
+{
+
+/** Service that lists and transfers littlefs files over a gpico::rpc
+ *  transport.
+ *
+ * Two methods are registered, numbered from the base given to the
+ * constructor (all integers little-endian):
+ *
+ *  - base + method::list: request {uint16_t start; char path[];}. Responds
+ *    with as many entries of the directory as fit in a response, starting at
+ *    entry number start, each {uint8_t type; uint32_t size; uint8_t length;
+ *    char name[length];}, with type being LFS_TYPE_REG or LFS_TYPE_DIR. An
+ *    empty response marks the end of the directory.
+ *  - base + method::read: request {uint32_t offset; uint32_t length; char
+ *    path[];}, with a length of 0 meaning up to the end of the file. Sends
+ *    the data as stream frames of up to GPICO_FILE_CHUNK_SIZE bytes, each
+ *    {uint32_t offset; std::byte data[];}, then responds with {uint32_t
+ *    length; uint32_t crc;}, the number of bytes sent and their CRC-32.
+ *
+ * Reads are double buffered: while a chunk is being sent over USB by the
+ * service's sender task, the next one is read from flash by the task running
+ * rpc::serve().
+ *
+ * littlefs is not thread-safe, so the filesystem must not be used by other
+ * tasks while a request is being handled.
+ */
+class file_service
+{
+public:
+	/// Size in bytes of each of the two chunk buffers.
+	static constexpr size_t chunk_size = GPICO_FILE_CHUNK_SIZE;
+
+	/** Methods of the service, relative to the base method id.
+	 */
+	enum method : uint8_t
+	{
+		list = 0,
+		read = 1,
+	};
+
+	/** Constructor.
+	 *
+	 * @param[in,out] transport Transport to serve requests through.
+	 * @param[in,out] fs Mounted filesystem to serve files from.
+	 * @param[in] base Method id of the first method of the service.
+	 */
+	file_service(rpc& transport, littlefs& fs, uint8_t base = 0x10);
+
+	file_service(const file_service&) = delete;
+	file_service& operator=(const file_service&) = delete;
+
+	/** Registers the methods of the service and starts its sender task.
+	 *
+	 * Must be called once, before transport.serve().
+	 *
+	 * @param[in] priority Priority of the sender task.
+	 *
+	 * @returns True on success, false if the methods could not be
+	 *  registered.
+	 */
+	bool start(UBaseType_t priority);
+
+private:
+	struct chunk
+	{
+		uint32_t offset;
+		uint32_t size;
+		std::array<std::byte, chunk_size> data;
+	};
+
+	rpc& transport_;
+	littlefs& fs_;
+	uint8_t base_;
+
+	std::array<chunk, 2> chunks_;
+	// Indices of the chunks ready to be sent, and of the free ones
+	StaticQueue_t ready_storage_;
+	std::array<uint8_t, 2> ready_buffer_;
+	QueueHandle_t ready_;
+	StaticQueue_t free_storage_;
+	std::array<uint8_t, 2> free_buffer_;
+	QueueHandle_t free_;
+	std::atomic<int> send_error_ = 0;
+
+	static_task<256> task_;
+
+	// Only used by the task serving requests
+	std::array<char, rpc::max_payload + 1> path_;
+
+	std::expected<size_t, int> list_dir(
+		std::span<const std::byte> request, std::span<std::byte> response);
+	std::expected<size_t, int> read_file(
+		std::span<const std::byte> request, std::span<std::byte> response);
+	std::expected<uint32_t, int> stream_file(
+		littlefs_file& file, uint32_t length, uint32_t& crc);
+	const char *get_path(std::span<const std::byte> data);
+
+	static void sender(void *param);
+};
+
+}
+
+#endif//GPICO_FILE_SERVICE_H_
@@ -311,7 +311,8 @@ public:
 	int close()
 	{
 		int result = lfs_file_close(&lfs_, &file);
-		open_ = open && result != 0;
+		// littlefs releases the file even if closing it fails
+		open_ = false;
 		return result;
 	}
 
@@ -325,12 +326,75 @@ public:
 		return lfs_file_read(&lfs_, &file, data.data(), data.size());
 	}
 
+	int seek(lfs_soff_t offset, int whence = LFS_SEEK_SET)
+	{
+		return lfs_file_seek(&lfs_, &file, offset, whence);
+	}
+
+	lfs_soff_t size()
+	{
+		return lfs_file_size(&lfs_, &file);
+	}
+
 private:
 	lfs& lfs_;
 	lfs_file file;
 	bool open_;
 };
 
+class littlefs_dir
+{
+public:
+	littlefs_dir(lfs_t& lfs_)
+	:lfs_(lfs_), open_(false)
+	{}
+
+	~littlefs_dir()
+	{
+		if (open_)
+		{
+			close();
+		}
+	}
+
+	littlefs_dir(const littlefs_dir&) = delete;
+	littlefs_dir& operator=(const littlefs_dir&) = delete;
+
+	int open(const char *path)
+	{
+		int result = lfs_dir_open(&lfs_, &dir, path);
+		open_ = result == 0;
+		return result;
+	}
+
+	int close()
+	{
+		int result = lfs_dir_close(&lfs_, &dir);
+		open_ = false;
+		return result;
+	}
+
+	/** Reads the next entry of the directory.
+	 *
+	 * @returns A positive value if an entry was read, 0 at the end of the
+	 *  directory, or a negative littlefs error code.
+	 */
+	int read(lfs_info& info)
+	{
+		return lfs_dir_read(&lfs_, &dir, &info);
+	}
+
+	int rewind()
+	{
+		return lfs_dir_rewind(&lfs_, &dir);
+	}
+
+private:
+	lfs& lfs_;
+	lfs_dir_t dir;
+	bool open_;
+};
+
 class littlefs
 {
 public:
@@ -375,6 +439,30 @@ public:
 		return std::unexpected(result);
 	}
 
+	/** Returns a closed file, to be opened in place.
+	 *
+	 * littlefs keeps track of open files by address, so files that are
+	 * opened and then moved (as open_file() does) must not be used with
+	 * other open files of the same filesystem. Opening the file returned
+	 * by this function where it is going to be used avoids that.
+	 */
+	littlefs_file file()
+	{
+		return littlefs_file(lfs);
+	}
+
+	/** Returns a closed directory, to be opened in place.
+	 */
+	littlefs_dir dir()
+	{
+		return littlefs_dir(lfs);
+	}
+
+	int stat(const char *path, lfs_info& info)
+	{
+		return lfs_stat(&lfs, path, &info);
+	}
+
 private:
 	flash& f;
 	lfs_t lfs;
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/** @file
+ * FreeRTOS hooks implemented by gpico.
+ *
+ * Include this at the end of the application's FreeRTOSConfig.h, after
+ * setting configGENERATE_RUN_TIME_STATS to 1. It backs the FreeRTOS run-time
+ * stats with the RP2040 microsecond timer, and hooks context switches to
+ * account for the busy time of each core, and to track the task the
+ * watchdog tasks preempt. Hooks already defined by the application are left
+ * alone.
+ *
+ * A 32-bit run-time counter wraps every ~71 minutes, so also setting
+ * configRUN_TIME_COUNTER_TYPE to uint64_t is recommended.
+ *
+ * When gpico is built with GPICO_TRACE, it also hooks context switches,
+ * tasks becoming ready, and tasks blocking on queues (and so on semaphores
+ * and mutexes) to record them in the trace buffer of gpico/trace.h.
+ *
+ * This header can be included from C.
+ */
+
+#ifndef GPICO_FREERTOS_HOOKS_H_
+#define GPICO_FREERTOS_HOOKS_H_
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Returns the value of the FreeRTOS run-time stats counter, in
+ *  microseconds since boot.
+ */
+uint64_t gpico_run_time_counter(void);
+
+/** Accounts for a task being switched in on the current core.
+ *
+ * Called by FreeRTOS with the scheduler locks held.
+ */
+void gpico_task_switched_in(void);
+
+/** Records the task being switched out on the current core, for the
+ *  watchdog record.
+ *
+ * Called by FreeRTOS with the scheduler locks held.
+ *
+ * @param[in] task Handle of the task.
+ */
+void gpico_task_switched_out(void *task);
+
+/// Trace event types, see gpico::trace_type.
+#define GPICO_TRACE_SWITCHED_IN 1
+#define GPICO_TRACE_SWITCHED_OUT 2
+#define GPICO_TRACE_TASK_READY 3
+#define GPICO_TRACE_QUEUE_BLOCK_SEND 4
+#define GPICO_TRACE_QUEUE_BLOCK_RECEIVE 5
+#define GPICO_TRACE_ISR_ENTER 6
+#define GPICO_TRACE_ISR_EXIT 7
+#define GPICO_TRACE_USER 8
+
+/** Records an event in the trace buffer of the current core.
+ *
+ * @param[in] type One of the GPICO_TRACE_* event types.
+ * @param[in] object Task, queue, or value the event refers to. Only the
+ *  lower 24 bits are kept.
+ */
+void gpico_trace_event(uint32_t type, const void *object);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifndef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#endif
+
+#ifndef portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE() gpico_run_time_counter()
+#endif
+
+#if configGENERATE_RUN_TIME_STATS == 1
+#define GPICO_HOOK_SWITCHED_IN() gpico_task_switched_in()
+#else
+#define GPICO_HOOK_SWITCHED_IN()
+#endif
+
+#if GPICO_TRACE
+#define GPICO_HOOK_TRACE(type, object) gpico_trace_event((type), (object))
+#else
+#define GPICO_HOOK_TRACE(type, object)
+#endif
+
+// pxCurrentTCB is only valid inside tasks.c, where these are expanded
+#ifndef traceTASK_SWITCHED_IN
+#define traceTASK_SWITCHED_IN() do { \
+	GPICO_HOOK_SWITCHED_IN(); \
+	GPICO_HOOK_TRACE(GPICO_TRACE_SWITCHED_IN, pxCurrentTCB); \
+} while (0)
+#endif
+
+#ifndef traceTASK_SWITCHED_OUT
+#define traceTASK_SWITCHED_OUT() do { \
+	gpico_task_switched_out(pxCurrentTCB); \
+	GPICO_HOOK_TRACE(GPICO_TRACE_SWITCHED_OUT, pxCurrentTCB); \
+} while (0)
+#endif
+
+#if GPICO_TRACE
+
+#ifndef traceMOVED_TASK_TO_READY_STATE
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) \
+	gpico_trace_event(GPICO_TRACE_TASK_READY, (pxTCB))
+#endif
+
+#ifndef traceBLOCKING_ON_QUEUE_SEND
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+	gpico_trace_event(GPICO_TRACE_QUEUE_BLOCK_SEND, (pxQueue))
+#endif
+
+#ifndef traceBLOCKING_ON_QUEUE_RECEIVE
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+	gpico_trace_event(GPICO_TRACE_QUEUE_BLOCK_RECEIVE, (pxQueue))
+#endif
+
+#endif//GPICO_TRACE
+
+#endif//__ASSEMBLER__
+
+#endif//GPICO_FREERTOS_HOOKS_H_
@@ -5,6 +5,10 @@
 #ifndef GPICO_IO_DEVICE_H_
 #define GPICO_IO_DEVICE_H_
 
+#include <FreeRTOS.h>
+#include <event_groups.h>
+
+#include <cstdint>
 #include <span>
 #include <memory>
 #include <expected>
@@ -12,6 +16,18 @@
 namespace gpico
 {
 
+/** Readiness of a file, as reported by file_descriptor::poll_ready().
+ */
+enum poll_event : uint8_t
+{
+	/// Data can be read without blocking.
+	poll_in = 1 << 0,
+	/// Data can be written without blocking.
+	poll_out = 1 << 1,
+	/// The other end went away, e.g. the host disconnected.
+	poll_hup = 1 << 2,
+};
+
 class file_descriptor
 {
 public:
@@ -41,6 +57,95 @@ public:
 	 *  (errno should also be set to something sensible).
 	 */
 	virtual int read(std::span<std::byte> buffer) = 0;
+
+	/** Writes the data in the given buffers to the file, in order.
+	 *
+	 * The default writes each buffer in turn, stopping at the first short
+	 * write. Implementations should override this if they can write all of
+	 * the data at once (e.g. without other writers interleaving data, or
+	 * with a single flush).
+	 *
+	 * @param[in] buffers Buffers with the data to write.
+	 *
+	 * @returns The total number of bytes written, or -1 on an error if
+	 *  nothing was written (errno should also be set to something sensible).
+	 */
+	virtual int writev(std::span<const std::span<const std::byte>> buffers)
+	{
+		int total = 0;
+		for (auto buffer : buffers)
+		{
+			int result = write(buffer);
+			if (result < 0)
+				return total ? total : result;
+			total += result;
+			if (static_cast<size_t>(result) < buffer.size())
+				break;
+		}
+		return total;
+	}
+
+	/** Reads data from the file into the given buffers, in order.
+	 *
+	 * The default reads into each buffer in turn, stopping at the first
+	 * short read, so it may block once per buffer. Implementations should
+	 * override this to block only until some data is available.
+	 *
+	 * @param[in] buffers Buffers to receive data from the file.
+	 *
+	 * @returns The total number of bytes read, or -1 on an error if nothing
+	 *  was read (errno should also be set to something sensible).
+	 */
+	virtual int readv(std::span<const std::span<std::byte>> buffers)
+	{
+		int total = 0;
+		for (auto buffer : buffers)
+		{
+			int result = read(buffer);
+			if (result < 0)
+				return total ? total : result;
+			total += result;
+			if (static_cast<size_t>(result) < buffer.size())
+				break;
+		}
+		return total;
+	}
+
+	/** Returns the current readiness of the file.
+	 *
+	 * The default reports the file as always readable and writable.
+	 *
+	 * @returns A combination of poll_event flags.
+	 */
+	virtual uint8_t poll_ready()
+	{
+		return poll_in | poll_out;
+	}
+
+	/** Returns the bit of the poll_events() event group set whenever the
+	 *  readiness of the file may have changed.
+	 *
+	 * The default returns 0, for files whose readiness never changes.
+	 *
+	 * @see allocate_poll_bit
+	 */
+	virtual EventBits_t poll_bit()
+	{
+		return 0;
+	}
+
+	/** Releases the resources held by the file.
+	 *
+	 * Called once the last file descriptor number referring to the file is
+	 * closed, and no other call is using it. The default does nothing.
+	 *
+	 * @returns 0 on success, or -1 on an error (errno should also be set to
+	 *  something sensible).
+	 */
+	virtual int close()
+	{
+		return 0;
+	}
 };
 
 /**Abstract class representing IO devices.
@@ -70,7 +175,9 @@ public:
 
 	/** Opens the device for read-write access.
 	 *
-	 * @param[in] path Path to the device to open.
+	 * @param[in] path Path within the device to open, relative to the prefix
+	 *  the device was registered with (empty when opening the device
+	 *  itself).
 	 *
 	 * @returns A file_descriptor pointer for file IO, or an error number in
 	 *  the case of failure.
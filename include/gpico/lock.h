@@ -2,13 +2,30 @@
 // SPDX-FileCopyrightText: Gabriel Marcano, 2025
 /// @file
 
+#ifndef GPICO_LOCK_H_
+#define GPICO_LOCK_H_
+
+#include <gpico/lock_stats.h>
+
+#include <hardware/sync.h>
+
 #include <FreeRTOS.h>
 #include <queue.h>
+#include <semphr.h>
 #include <task.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
 namespace gpico
 {
 
+/** Mutex for tasks, a FreeRTOS mutex with priority inheritance.
+ *
+ * When gpico is built with GPICO_LOCK_STATS, it keeps contention statistics
+ * (see gpico/lock_stats.h), reported under the name it is constructed with.
+ */
 class mutex
 {
 public:
@@ -16,94 +33,504 @@ public:
 	mutex& operator=(const mutex&) = delete;
 
 	mutex()
+	:mutex(nullptr)
+	{}
+
+	/** Constructor.
+	 *
+	 * @param[in] name Name for the lock statistics, must outlive the mutex.
+	 */
+	explicit mutex(const char *name)
+	:profile(this, name)
 	{
 		handle = xSemaphoreCreateMutexStatic(&storage);
 	}
 
 	void lock()
 	{
+		if (xSemaphoreTake(handle, 0))
+		{
+			profile.acquired();
+			return;
+		}
+		const auto start = profile.wait();
 		xSemaphoreTake(handle, portMAX_DELAY);
+		profile.acquired(start);
 	}
 
 	bool try_lock()
 	{
-		return xSemaphoreTake(handle, 0);
+		if (!xSemaphoreTake(handle, 0))
+			return false;
+		profile.acquired();
+		return true;
 	}
 
 	void unlock()
 	{
+		profile.released();
 		xSemaphoreGive(handle);
 	}
 private:
 	StaticSemaphore_t storage;
 	SemaphoreHandle_t handle;
+	[[no_unique_address]] lock_profile profile;
+};
+
+/** Mutex that can be locked again by the task holding it.
+ *
+ * Every lock must be matched by an unlock. Only the outermost lock counts
+ * for the lock statistics.
+ */
+class recursive_mutex
+{
+public:
+	recursive_mutex(const recursive_mutex&) = delete;
+	recursive_mutex& operator=(const recursive_mutex&) = delete;
+
+	recursive_mutex()
+	:recursive_mutex(nullptr)
+	{}
+
+	/** Constructor.
+	 *
+	 * @param[in] name Name for the lock statistics, must outlive the mutex.
+	 */
+	explicit recursive_mutex(const char *name)
+	:profile(this, name)
+	{
+		handle = xSemaphoreCreateRecursiveMutexStatic(&storage);
+	}
+
+	void lock()
+	{
+		if (xSemaphoreTakeRecursive(handle, 0))
+		{
+			if (!depth++)
+				profile.acquired();
+			return;
+		}
+		const auto start = profile.wait();
+		xSemaphoreTakeRecursive(handle, portMAX_DELAY);
+		++depth;
+		profile.acquired(start);
+	}
+
+	bool try_lock()
+	{
+		if (!xSemaphoreTakeRecursive(handle, 0))
+			return false;
+		if (!depth++)
+			profile.acquired();
+		return true;
+	}
+
+	void unlock()
+	{
+		if (!--depth)
+			profile.released();
+		xSemaphoreGiveRecursive(handle);
+	}
+private:
+	StaticSemaphore_t storage;
+	SemaphoreHandle_t handle;
+	// Times locked by the owner, only used by the owner
+	UBaseType_t depth = 0;
+	[[no_unique_address]] lock_profile profile;
 };
 
+/** Short critical section lock backed by an RP2040 hardware spin lock.
+ *
+ * Locking disables interrupts on the calling core and spins until the other
+ * core releases the lock, so it is much cheaper than a mutex for updating a
+ * few words of state shared between cores, and can be used from interrupt
+ * handlers. In exchange, the section must be short, must not block or call
+ * FreeRTOS functions, and must not lock another spinlock.
+ */
+class spinlock
+{
+public:
+	spinlock(const spinlock&) = delete;
+	spinlock& operator=(const spinlock&) = delete;
+
+	/** Constructor, claims an unused hardware spin lock.
+	 *
+	 * Panics if there are none left.
+	 *
+	 * @param[in] name Name for the lock statistics, must outlive the lock.
+	 */
+	explicit spinlock(const char *name = nullptr)
+	:spinlock(spin_lock_claim_unused(true), name)
+	{
+		claimed = true;
+	}
+
+	/** Constructor, uses the given hardware spin lock.
+	 *
+	 * @param[in] number Number of the hardware spin lock, which must not be
+	 *  locked by anything else while this is locked.
+	 * @param[in] name Name for the lock statistics, must outlive the lock.
+	 */
+	explicit spinlock(unsigned number, const char *name = nullptr)
+	:spin(spin_lock_instance(number)), profile(this, name)
+	{}
+
+	~spinlock()
+	{
+		if (claimed)
+			spin_lock_unclaim(spin_lock_get_num(spin));
+	}
+
+	void lock()
+	{
+		const uint32_t saved = save_and_disable_interrupts();
+		if (spin_try_lock_unsafe(spin))
+		{
+			profile.acquired();
+		}
+		else
+		{
+			const auto start = profile.wait();
+			spin_lock_unsafe_blocking(spin);
+			profile.acquired(start);
+		}
+		status = saved;
+	}
+
+	bool try_lock()
+	{
+		const uint32_t saved = save_and_disable_interrupts();
+		if (!spin_try_lock_unsafe(spin))
+		{
+			restore_interrupts(saved);
+			return false;
+		}
+		profile.acquired();
+		status = saved;
+		return true;
+	}
+
+	void unlock()
+	{
+		profile.released();
+		spin_unlock(spin, status);
+	}
+
+private:
+	spin_lock_t *spin;
+	// Interrupt state of the core holding the lock, from before locking
+	uint32_t status = 0;
+	bool claimed = false;
+	[[no_unique_address]] lock_profile profile;
+};
+
+/** Reader-writer mutex.
+ *
+ * Any number of tasks can hold it shared, or a single task exclusively.
+ * Tasks waiting to lock it exclusively hold off new shared owners, so
+ * writers are not starved by a stream of readers. Works with
+ * std::shared_lock through lock_shared() and unlock_shared().
+ */
+class shared_mutex
+{
+public:
+	shared_mutex(const shared_mutex&) = delete;
+	shared_mutex& operator=(const shared_mutex&) = delete;
+
+	shared_mutex()
+	{
+		// A semaphore and not a mutex, as the last reader releases it on
+		// behalf of the first one
+		exclusive = xSemaphoreCreateBinaryStatic(&exclusive_storage);
+		xSemaphoreGive(exclusive);
+	}
+
+	void lock()
+	{
+		turnstile.lock();
+		xSemaphoreTake(exclusive, portMAX_DELAY);
+		turnstile.unlock();
+	}
+
+	bool try_lock()
+	{
+		return xSemaphoreTake(exclusive, 0);
+	}
+
+	void unlock()
+	{
+		xSemaphoreGive(exclusive);
+	}
+
+	void lock_shared()
+	{
+		// Wait for any writer that got here first
+		turnstile.lock();
+		turnstile.unlock();
+
+		readers_lock.lock();
+		if (++readers == 1)
+			xSemaphoreTake(exclusive, portMAX_DELAY);
+		readers_lock.unlock();
+	}
+
+	bool try_lock_shared()
+	{
+		if (!readers_lock.try_lock())
+			return false;
+		bool result = readers || xSemaphoreTake(exclusive, 0);
+		if (result)
+			++readers;
+		readers_lock.unlock();
+		return result;
+	}
+
+	void unlock_shared()
+	{
+		readers_lock.lock();
+		if (--readers == 0)
+			xSemaphoreGive(exclusive);
+		readers_lock.unlock();
+	}
+
+private:
+	StaticSemaphore_t exclusive_storage;
+	SemaphoreHandle_t exclusive;
+	mutex turnstile;
+	mutex readers_lock;
+	size_t readers = 0;
+};
+
+/** Condition variable for any lockable type.
+ *
+ * Like std::condition_variable_any, waiters may wake up spuriously, so they
+ * should wait for a predicate. Timeouts are in FreeRTOS ticks.
+ */
+class condition_variable
+{
+public:
+	condition_variable(const condition_variable&) = delete;
+	condition_variable& operator=(const condition_variable&) = delete;
+
+	condition_variable()
+	{
+		signals = xSemaphoreCreateCountingStatic(
+			std::numeric_limits<UBaseType_t>::max(), 0, &signals_storage);
+	}
+
+	/** Wakes up one waiting task, if any.
+	 */
+	void notify_one()
+	{
+		taskENTER_CRITICAL();
+		if (waiters)
+		{
+			--waiters;
+			xSemaphoreGive(signals);
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	/** Wakes up all waiting tasks.
+	 */
+	void notify_all()
+	{
+		taskENTER_CRITICAL();
+		for (; waiters; --waiters)
+			xSemaphoreGive(signals);
+		taskEXIT_CRITICAL();
+	}
+
+	/** Unlocks lock and waits to be notified, then locks it again.
+	 *
+	 * @param[in,out] lock Lock held by the calling task.
+	 */
+	template<class Lock>
+	void wait(Lock& lock)
+	{
+		wait_for(lock, portMAX_DELAY);
+	}
+
+	/** Waits until pred returns true.
+	 *
+	 * @param[in,out] lock Lock held by the calling task.
+	 * @param[in] pred Predicate, checked with the lock held.
+	 */
+	template<class Lock, class Predicate>
+	void wait(Lock& lock, Predicate pred)
+	{
+		while (!pred())
+			wait(lock);
+	}
+
+	/** Unlocks lock and waits to be notified or for a timeout, then locks it
+	 *  again.
+	 *
+	 * @param[in,out] lock Lock held by the calling task.
+	 * @param[in] timeout Longest time to wait for, in ticks.
+	 *
+	 * @returns False on timeout, true otherwise.
+	 */
+	template<class Lock>
+	bool wait_for(Lock& lock, TickType_t timeout)
+	{
+		taskENTER_CRITICAL();
+		++waiters;
+		taskEXIT_CRITICAL();
+
+		lock.unlock();
+		bool result = xSemaphoreTake(signals, timeout);
+		if (!result)
+		{
+			// Either no longer wait, or take the notification that raced the
+			// timeout, so it isn't left for a later waiter
+			taskENTER_CRITICAL();
+			if (xSemaphoreTake(signals, 0))
+				result = true;
+			else
+				--waiters;
+			taskEXIT_CRITICAL();
+		}
+		lock.lock();
+		return result;
+	}
+
+	/** Waits until pred returns true, or for a timeout.
+	 *
+	 * @param[in,out] lock Lock held by the calling task.
+	 * @param[in] timeout Longest time to wait for, in ticks.
+	 * @param[in] pred Predicate, checked with the lock held.
+	 *
+	 * @returns The last value returned by pred.
+	 */
+	template<class Lock, class Predicate>
+	bool wait_for(Lock& lock, TickType_t timeout, Predicate pred)
+	{
+		TimeOut_t start;
+		vTaskSetTimeOutState(&start);
+		while (!pred())
+		{
+			if (xTaskCheckForTimeOut(&start, &timeout) || !wait_for(lock, timeout))
+				return pred();
+		}
+		return true;
+	}
+
+private:
+	StaticSemaphore_t signals_storage;
+	SemaphoreHandle_t signals;
+	// Tasks waiting that haven't been notified yet
+	UBaseType_t waiters = 0;
+};
+
+/** Movable lock owning a mutex, like std::unique_lock.
+ *
+ * All of gpico's lock types also work with std::lock_guard,
+ * std::scoped_lock, and std::unique_lock.
+ */
 template <class T>
 class unique_lock
 {
 public:
-	unique_lock(T& mutex)
-	:mutex_(&mutex)
+	explicit unique_lock(T& mutex)
+	:mutex_(&mutex), owns_(true)
 	{
 		mutex_->lock();
 	}
 
-	unique_lock(T&& lock)
-	:mutex(&lock.mutex)
+	unique_lock(unique_lock&& lock)
+	:mutex_(lock.mutex_), owns_(lock.owns_)
 	{
 		lock.mutex_ = nullptr;
+		lock.owns_ = false;
 	}
 
+	unique_lock(const unique_lock&) = delete;
+	unique_lock& operator=(const unique_lock&) = delete;
+
 	~unique_lock()
 	{
-		release();
+		if (owns_)
+			mutex_->unlock();
 	}
 
-	unique_lock& operator=(T& mutex__)
+	/** Unlocks the mutex owned, if any, and locks another one.
+	 */
+	unique_lock& operator=(T& mutex)
 	{
-		if (mutex_)
-		{
+		if (owns_)
 			mutex_->unlock();
-		}
 
-		mutex_ = &mutex__;
+		mutex_ = &mutex;
 		mutex_->lock();
+		owns_ = true;
+		return *this;
 	}
 
 	unique_lock& operator=(unique_lock&& lock)
 	{
-		mutex_ = lock.mutex_;
-		lock.mutex_ = nullptr;
+		if (this != &lock)
+		{
+			if (owns_)
+				mutex_->unlock();
+			mutex_ = lock.mutex_;
+			owns_ = lock.owns_;
+			lock.mutex_ = nullptr;
+			lock.owns_ = false;
+		}
 		return *this;
 	}
 
 	void lock()
 	{
 		mutex_->lock();
+		owns_ = true;
 	}
 
 	void unlock()
 	{
 		mutex_->unlock();
+		owns_ = false;
 	}
 
 	bool try_lock()
 	{
-		return mutex_->try_lock();
+		owns_ = mutex_->try_lock();
+		return owns_;
 	}
 
-	void release()
+	/** Disassociates the mutex without unlocking it.
+	 *
+	 * @returns The mutex, which the caller must unlock if it was owned.
+	 */
+	T* release()
 	{
-		if (mutex_)
-		{
-			mutex_->unlock();
-			mutex_ = nullptr;
-		}
+		T* result = mutex_;
+		mutex_ = nullptr;
+		owns_ = false;
+		return result;
+	}
+
+	bool owns_lock() const
+	{
+		return owns_;
+	}
+
+	explicit operator bool() const
+	{
+		return owns_;
+	}
+
+	T* mutex() const
+	{
+		return mutex_;
 	}
 
 private:
 	T* mutex_;
+	bool owns_;
 };
 
 }
+
+#endif//GPICO_LOCK_H_
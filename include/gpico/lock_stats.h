@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_LOCK_STATS_H_
+#define GPICO_LOCK_STATS_H_
+
+#include <pico/time.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#ifndef GPICO_LOCK_STATS
+#define GPICO_LOCK_STATS 0
+#endif
+
+namespace gpico
+{
+
+/** Contention statistics of a lock, as returned by get_lock_stats().
+ */
+struct lock_stats
+{
+	/// Address of the lock.
+	const void *lock;
+	/// Name given to the lock, or null.
+	const char *name;
+	/// Times the lock was acquired.
+	uint32_t acquisitions;
+	/// Times the lock was acquired after waiting for another owner.
+	uint32_t contended;
+	/// Total time spent waiting for the lock, in microseconds.
+	uint64_t total_wait_us;
+	/// Longest wait for the lock, in microseconds.
+	uint32_t max_wait_us;
+	/// Longest time the lock was held, in microseconds.
+	uint32_t max_hold_us;
+	/// Task that acquired the lock last, null if none has.
+	TaskHandle_t last_owner;
+};
+
+#if GPICO_LOCK_STATS
+
+/** Contention statistics kept by an instrumented lock.
+ *
+ * The lock reports every acquisition and release, which are only updated by
+ * the owner of the lock, so they need no locking of their own. Every profile
+ * is kept in a registry for get_lock_stats() for as long as it lives.
+ */
+class lock_profile
+{
+public:
+	/// Time a wait for the lock started at.
+	struct wait_start
+	{
+		uint32_t time;
+	};
+
+	explicit lock_profile(const void *lock, const char *name);
+	~lock_profile();
+
+	lock_profile(const lock_profile&) = delete;
+	lock_profile& operator=(const lock_profile&) = delete;
+
+	/** Marks the start of a wait for the lock, after failing to take it.
+	 */
+	static wait_start wait()
+	{
+		return {time_us_32()};
+	}
+
+	/** Records an acquisition that didn't have to wait.
+	 */
+	void acquired()
+	{
+		acquired_at = time_us_32();
+		++stats.acquisitions;
+		stats.last_owner = xTaskGetCurrentTaskHandle();
+	}
+
+	/** Records an acquisition after waiting for it.
+	 *
+	 * @param[in] start When the wait started.
+	 */
+	void acquired(wait_start start)
+	{
+		acquired();
+		const uint32_t waited = acquired_at - start.time;
+		++stats.contended;
+		stats.total_wait_us += waited;
+		stats.max_wait_us = std::max(stats.max_wait_us, waited);
+	}
+
+	/** Records a release, before the lock is released.
+	 */
+	void released()
+	{
+		stats.max_hold_us = std::max(stats.max_hold_us, time_us_32() - acquired_at);
+	}
+
+private:
+	friend std::expected<size_t, int> get_lock_stats(std::span<lock_stats> stats);
+	friend void reset_lock_stats();
+
+	lock_stats stats;
+	uint32_t acquired_at = 0;
+	lock_profile *previous = nullptr;
+	lock_profile *next = nullptr;
+};
+
+#else
+
+// Does nothing, so locks keep no statistics
+class lock_profile
+{
+public:
+	struct wait_start {};
+
+	constexpr explicit lock_profile(const void*, const char*) {}
+
+	static wait_start wait()
+	{
+		return {};
+	}
+
+	void acquired() {}
+	void acquired(wait_start) {}
+	void released() {}
+};
+
+#endif//GPICO_LOCK_STATS
+
+/** Returns the contention statistics of every live instrumented lock.
+ *
+ * gpico::mutex, gpico::recursive_mutex, and gpico::spinlock are instrumented
+ * when gpico is built with GPICO_LOCK_STATS, otherwise there are no
+ * statistics. Statistics are updated by the owner of each lock without
+ * stopping while they are read, so the ones of a lock in use may be off by an
+ * acquisition.
+ *
+ * @param[out] stats Where to write the statistics of each lock.
+ *
+ * @returns The number of entries written, or ENOBUFS if there are more locks
+ *  than entries in stats, in which case all of stats is written.
+ */
+std::expected<size_t, int> get_lock_stats(std::span<lock_stats> stats);
+
+/** Clears the statistics of every instrumented lock.
+ */
+void reset_lock_stats();
+
+/** Logs the statistics of every instrumented lock that has been contended to
+ *  sys_log, most waited for first.
+ */
+void log_lock_stats();
+
+}
+
+#endif//GPICO_LOCK_STATS_H_
@@ -7,11 +7,84 @@
 
 #include <gpico/syslog.h>
 
+#include <cstdarg>
+
+#ifndef GPICO_SYSLOG_SIZE
+#define GPICO_SYSLOG_SIZE (1024*4)
+#endif
+
+#ifndef GPICO_SYSLOG_PERSISTENT
+#define GPICO_SYSLOG_PERSISTENT 0
+#endif
+
+#ifndef GPICO_LOG_MAX_LENGTH
+#define GPICO_LOG_MAX_LENGTH 128
+#endif
+
 namespace gpico
 {
-	// FIXME we probably shouldn't have a fixed size... let the application set
-	// the size!
-	extern safe_syslog<syslog<1024*4>> sys_log;
+	/** Type of the system log.
+	 *
+	 * The size in bytes is set by the application through the
+	 * GPICO_SYSLOG_SIZE CMake cache variable, and whether it survives warm
+	 * resets through the GPICO_SYSLOG_PERSISTENT CMake option.
+	 */
+	using sys_log_type =
+		safe_syslog<syslog<GPICO_SYSLOG_SIZE, GPICO_SYSLOG_PERSISTENT>>;
+
+	/** System log.
+	 *
+	 * The log storage is part of the object, so it can be moved to a specific
+	 * memory region (e.g. one of the RP2040 scratch SRAM banks) through the
+	 * GPICO_SYSLOG_SECTION CMake cache variable.
+	 *
+	 * If persistent, entries from before a warm reset are kept, and
+	 * sys_log.recovered() returns how many there are.
+	 */
+	extern sys_log_type sys_log;
+
+	/** Formats and pushes an entry to sys_log, if it passes the runtime
+	 *  filter.
+	 *
+	 * The filter is checked before formatting, so filtered out entries are
+	 * cheap. Prefer using gpico::log, which also honors the compile-time
+	 * minimum level.
+	 *
+	 * The entry is formatted into a buffer on the stack of the caller, and
+	 * truncated to GPICO_LOG_MAX_LENGTH characters, or to the longest entry
+	 * sys_log can hold if that is shorter.
+	 *
+	 * @param[in] level Severity of the entry.
+	 * @param[in] module Module tag of the entry, or null.
+	 * @param[in] format printf style format string.
+	 * @param[in] args Arguments for the format string.
+	 */
+	void vlog(log_level level, const char *module, const char *format, va_list args);
+
+	/** Formats and pushes an entry to sys_log.
+	 *
+	 * If the level is below the compile-time minimum (GPICO_LOG_MIN_LEVEL),
+	 * this function is empty and calls to it are optimized away. Note that
+	 * arguments with side-effects are still evaluated.
+	 *
+	 * @tparam level Severity of the entry.
+	 *
+	 * @param[in] module Module tag of the entry, or null. The string must
+	 *  outlive the log, which is the case for string literals.
+	 * @param[in] format printf style format string.
+	 */
+	template<log_level level>
+	[[gnu::format(printf, 2, 3)]]
+	inline void log(const char *module, const char *format, ...)
+	{
+		if constexpr (level >= min_log_level)
+		{
+			va_list args;
+			va_start(args, format);
+			vlog(level, module, format, args);
+			va_end(args);
+		}
+	}
 }
 
 #endif//GPICO_LOG_H_
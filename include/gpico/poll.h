@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_POLL_H_
+#define GPICO_POLL_H_
+
+#include <gpico/io_device.h>
+
+#include <FreeRTOS.h>
+#include <event_groups.h>
+
+#include <cstdint>
+#include <span>
+
+namespace gpico
+{
+	/** File to wait on with poll().
+	 */
+	struct poll_fd
+	{
+		/// File to wait on.
+		file_descriptor *file;
+		/// poll_event flags to wait for. poll_hup is always reported.
+		uint8_t events;
+		/// poll_event flags that were ready, set by poll().
+		uint8_t revents;
+	};
+
+	/** Returns the event group files use to signal readiness changes.
+	 *
+	 * Each file that can change readiness owns one bit of the group.
+	 */
+	EventGroupHandle_t poll_events();
+
+	/** Allocates a bit of the poll_events() event group for a file.
+	 *
+	 * There are only as many bits as a FreeRTOS event group has (24, or 8
+	 * with 16-bit ticks), shared by all files.
+	 *
+	 * @returns The bit allocated, or 0 if there are none left, in which case
+	 *  poll() notices readiness changes of the file only when woken up by
+	 *  other files or timing out.
+	 */
+	EventBits_t allocate_poll_bit();
+
+	/** Waits until at least one of the given files is ready.
+	 *
+	 * This blocks the calling task without using the CPU. A file should only
+	 * be waited on by one task at a time, as waiting consumes the readiness
+	 * notification of the file.
+	 *
+	 * @param[in,out] fds Files to wait on. Their revents member is updated.
+	 * @param[in] timeout Maximum time to wait, in ticks. 0 checks the files
+	 *  without blocking, and portMAX_DELAY waits forever.
+	 *
+	 * @returns The number of files with revents set, 0 if the timeout
+	 *  expired.
+	 */
+	int poll(std::span<poll_fd> fds, TickType_t timeout);
+}
+
+#endif//GPICO_POLL_H_
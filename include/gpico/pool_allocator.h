@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_POOL_ALLOCATOR_H_
+#define GPICO_POOL_ALLOCATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef GPICO_POOL_ALLOCATOR
+#define GPICO_POOL_ALLOCATOR 0
+#endif
+
+#ifndef GPICO_POOL_BLOCKS
+#define GPICO_POOL_BLOCKS 64, 64, 32, 16, 8
+#endif
+
+namespace gpico
+{
+
+/** Number of blocks of each size class of the pool allocator.
+ *
+ * Class i holds blocks of 16 << i bytes.
+ */
+constexpr std::array<size_t, 5> pool_blocks = {GPICO_POOL_BLOCKS};
+
+/** Statistics of a size class of the pool allocator.
+ */
+struct pool_class_stats
+{
+	/// Size of the blocks of the class, in bytes.
+	size_t block_size;
+	/// Number of blocks of the class.
+	size_t blocks;
+	/// Blocks allocated right now.
+	size_t in_use;
+	/// Most blocks ever allocated at once.
+	size_t high_water;
+	/// Allocations served by the class.
+	uint32_t allocations;
+	/// Allocations that fit the class, but found it full and spilled over to
+	/// a larger class or to malloc.
+	uint32_t failures;
+};
+
+/** Statistics of the pool allocator.
+ */
+struct pool_stats
+{
+	/// Statistics of each size class.
+	std::array<pool_class_stats, pool_blocks.size()> classes;
+	/// Allocations served by malloc, for being too large or for their class
+	/// being full.
+	uint32_t fallback_allocations;
+	/// Allocations malloc failed to serve.
+	uint32_t fallback_failures;
+};
+
+/** Allocates memory from the pool allocator.
+ *
+ * Requests of up to the largest block size are served in constant time from
+ * the smallest size class that fits them and has free blocks, larger ones
+ * (or ones that find their classes full) by malloc. Blocks are aligned to 8
+ * bytes. Safe to call from any task, core, or interrupt handler, except for
+ * the malloc fallback, which can't be used from interrupt handlers.
+ *
+ * Only available when gpico is built with GPICO_POOL_ALLOCATOR, which also
+ * makes operator new and operator delete use this allocator.
+ *
+ * @param[in] size Number of bytes to allocate.
+ *
+ * @returns The memory allocated, or null if there is none left.
+ */
+void *pool_allocate(size_t size);
+
+/** Frees memory allocated by pool_allocate().
+ *
+ * @param[in] ptr Memory to free, or null.
+ */
+void pool_free(void *ptr);
+
+/** Returns the live statistics of the pool allocator.
+ *
+ * The statistics of each class are consistent with each other, but not
+ * necessarily with the ones of the other classes.
+ */
+pool_stats get_pool_stats();
+
+}
+
+#endif//GPICO_POOL_ALLOCATOR_H_
@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_RPC_H_
+#define GPICO_RPC_H_
+
+#include <gpico/cdc_device.h>
+#include <gpico/cobs.h>
+#include <gpico/lock.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <initializer_list>
+#include <span>
+
+#ifndef GPICO_RPC_MAX_PAYLOAD
+#define GPICO_RPC_MAX_PAYLOAD 256
+#endif
+
+#ifndef GPICO_RPC_MAX_METHODS
+#define GPICO_RPC_MAX_METHODS 16
+#endif
+
+namespace gpico
+{
+
+/** Framed binary RPC and telemetry transport over a CDC device.
+ *
+ * Every message is a frame made of a header, a payload, and the CRC-32 of
+ * both (little-endian), COBS encoded and terminated by a zero byte:
+ *
+ *     header { uint8_t kind; uint8_t id; uint16_t tag; }
+ *
+ * The host sends requests, with id naming the method to call and a tag of its
+ * choosing. The device answers every request with a response or an error,
+ * echoing the request's id and tag. An error payload is the int32_t errno
+ * value describing the failure. Frames with a bad CRC are dropped, so the host
+ * is expected to time out and retry.
+ *
+ * While handling a request, the device may send any number of stream frames,
+ * with the request's id and tag, ahead of the response. This is how bulk
+ * data larger than a response payload is returned.
+ *
+ * The device also sends publish frames, with id naming the topic, for every
+ * topic the host subscribed to through the subscribe method (payload: one
+ * byte with the topic number).
+ *
+ * The CDC device should be dedicated to this transport, as any other data
+ * written to it corrupts frames.
+ */
+class rpc
+{
+public:
+	/// Largest request or response payload, in bytes.
+	static constexpr size_t max_payload = GPICO_RPC_MAX_PAYLOAD;
+	/// Largest number of methods that can be registered.
+	static constexpr size_t max_methods = GPICO_RPC_MAX_METHODS;
+	/// Largest number of parts a published message can be made of.
+	static constexpr size_t max_parts = 6;
+
+	/** Kinds of frames.
+	 */
+	enum class kind : uint8_t
+	{
+		request = 0,
+		response = 1,
+		error = 2,
+		publish = 3,
+		stream = 4,
+	};
+
+	/** Frame header.
+	 */
+	struct header
+	{
+		kind type;
+		uint8_t id;
+		uint16_t tag;
+	};
+
+	/** Methods handled by the transport itself.
+	 *
+	 * Method ids from reserved up are not available to applications.
+	 */
+	enum method : uint8_t
+	{
+		/// First method id reserved for the transport.
+		reserved = 0xF0,
+		/// Responds with the request's payload.
+		ping = 0xF0,
+		/// Starts publishing the topic in the payload's only byte.
+		subscribe = 0xF1,
+		/// Stops publishing the topic in the payload's only byte.
+		unsubscribe = 0xF2,
+	};
+
+	/** Topics published by the transport itself.
+	 *
+	 * Topics are numbered from 0 to 31.
+	 */
+	enum topic : uint8_t
+	{
+		/// Records pushed to the log passed to forward_log().
+		log = 0,
+		/// First topic available to applications.
+		user = 1,
+	};
+
+	/** Method handler.
+	 *
+	 * Takes the request payload and a buffer of max_payload bytes for the
+	 * response payload, and returns the size of the response or an errno
+	 * value describing the failure.
+	 */
+	using handler = std::function<std::expected<size_t, int>(
+		std::span<const std::byte> request, std::span<std::byte> response)>;
+
+	/** Constructor.
+	 *
+	 * @param[in,out] device CDC device dedicated to this transport.
+	 */
+	explicit rpc(cdc_device& device);
+
+	rpc(const rpc&) = delete;
+	rpc& operator=(const rpc&) = delete;
+
+	/** Registers a method.
+	 *
+	 * Methods must be registered before serve() is called.
+	 *
+	 * @param[in] id Method id, less than method::reserved.
+	 * @param[in] func Handler of the method.
+	 *
+	 * @returns True on success, false if the id is reserved or in use, or if
+	 *  there is no room for more methods.
+	 */
+	bool register_method(uint8_t id, handler func);
+
+	/** Receives and dispatches requests, forever.
+	 *
+	 * Handlers run in the calling task, so this is meant to be the body of a
+	 * task dedicated to the transport. Subscriptions are dropped whenever the
+	 * host disconnects.
+	 */
+	[[noreturn]] void serve();
+
+	/** Returns whether the host is subscribed to the given topic.
+	 *
+	 * Useful to skip gathering telemetry no one is listening to.
+	 */
+	bool subscribed(uint8_t topic) const;
+
+	/** Publishes a message to a topic, if the host is subscribed to it.
+	 *
+	 * The message is sent straight from the given buffers, so it can be made
+	 * of e.g. a header and a body without copying them together first.
+	 *
+	 * @param[in] topic Topic to publish to.
+	 * @param[in] parts Parts of the message, in order. At most max_parts.
+	 *
+	 * @returns Nothing on success, including when the host is not subscribed,
+	 *  or an errno value on failure.
+	 */
+	std::expected<void, int> publish(
+		uint8_t topic, std::span<const std::span<const std::byte>> parts);
+
+	/** Publishes a message to a topic, if the host is subscribed to it.
+	 *
+	 * @see publish
+	 */
+	std::expected<void, int> publish(
+		uint8_t topic, std::initializer_list<std::span<const std::byte>> parts)
+	{
+		return publish(topic, std::span(parts.begin(), parts.size()));
+	}
+
+	/** Sends a stream frame for the request being handled.
+	 *
+	 * This must only be called while a handler runs, either by the handler
+	 * or by a task the handler waits for. Like publish(), the frame is sent
+	 * straight from the given buffers, and its size is not limited by
+	 * max_payload.
+	 *
+	 * @param[in] parts Parts of the frame payload, in order. At most
+	 *  max_parts.
+	 *
+	 * @returns Nothing on success, or an errno value on failure.
+	 */
+	std::expected<void, int> stream(
+		std::span<const std::span<const std::byte>> parts);
+
+	/** Sends a stream frame for the request being handled.
+	 *
+	 * @see stream
+	 */
+	std::expected<void, int> stream(
+		std::initializer_list<std::span<const std::byte>> parts)
+	{
+		return stream(std::span(parts.begin(), parts.size()));
+	}
+
+	/** Publishes the records pushed to the given log to topic::log.
+	 *
+	 * This replaces any push callback registered with the log. Records are
+	 * published from the task logging them, while it holds the log's lock,
+	 * so they are never waited for: a record is dropped, and counted by
+	 * dropped_log_records(), if another frame is being sent or it doesn't
+	 * fit in the transmit buffer of the device, e.g. because the host
+	 * stopped reading.
+	 *
+	 * @tparam Log Log type, e.g. sys_log_type.
+	 *
+	 * @param[in,out] log Log to forward.
+	 */
+	template<class Log>
+	void forward_log(Log& log)
+	{
+		log.register_push_callback([this](std::string_view record) {
+			if (!subscribed(topic::log))
+				return;
+			const std::span<const std::byte> part = std::as_bytes(std::span(record));
+			if (!send({kind::publish, topic::log, 0}, std::span(&part, 1), false))
+				++dropped_log_records_;
+		});
+	}
+
+	/** Returns the number of log records forward_log() has dropped.
+	 */
+	uint32_t dropped_log_records() const
+	{
+		return dropped_log_records_;
+	}
+
+private:
+	static constexpr size_t max_frame =
+		sizeof(header) + max_payload + sizeof(uint32_t);
+
+	cdc_device& device_;
+	mutex send_lock_;
+	std::atomic<uint32_t> subscriptions_ = 0;
+	std::atomic<uint32_t> dropped_log_records_ = 0;
+
+	std::array<std::pair<uint8_t, handler>, max_methods> methods_;
+	size_t method_count_ = 0;
+	header request_ = {};
+
+	std::array<std::byte, max_frame> rx_buffer_;
+	std::array<std::byte, max_payload> response_buffer_;
+	cobs::decoder decoder_;
+
+	// Without block, fails with EAGAIN instead of waiting for other senders
+	// or for room in the transmit buffer
+	std::expected<void, int> send(
+		header head, std::span<const std::span<const std::byte>> parts,
+		bool block = true);
+	void dispatch(std::span<const std::byte> frame);
+	std::expected<size_t, int> call(
+		uint8_t id, std::span<const std::byte> request);
+};
+
+}
+
+#endif//GPICO_RPC_H_
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_STACK_MONITOR_H_
+#define GPICO_STACK_MONITOR_H_
+
+#include <gpico/static_task.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#ifndef GPICO_STACK_MONITOR_MAX_TASKS
+#define GPICO_STACK_MONITOR_MAX_TASKS 24
+#endif
+
+namespace gpico
+{
+
+/** Stack usage of a task, as returned by stack_high_water_marks().
+ */
+struct task_stack
+{
+	/// Task handle.
+	TaskHandle_t task;
+	/// Task name.
+	std::array<char, configMAX_TASK_NAME_LEN> name;
+	/// Least stack the task has had free since it started, in words.
+	uint32_t free_words;
+};
+
+/** Returns the stack high water mark of every task.
+ *
+ * Requires configUSE_TRACE_FACILITY. FreeRTOS finds each mark by scanning
+ * the unused part of the stack of the task, so this takes a while with many
+ * or large stacks.
+ *
+ * @param[out] status Buffer for the state of each task, as large as stacks.
+ * @param[out] stacks Where to write the usage of each task.
+ *
+ * @returns The number of entries written, or ENOBUFS if there are more tasks
+ *  than entries in status or stacks.
+ */
+std::expected<size_t, int> stack_high_water_marks(
+	std::span<TaskStatus_t> status, std::span<task_stack> stacks);
+
+/** Logs the stack high water mark of every task to sys_log.
+ *
+ * Logs an error instead if there are more than stack_monitor::max_tasks
+ * tasks.
+ */
+void log_stack_high_water_marks();
+
+/** Monitor of the stack high water marks of all tasks.
+ *
+ * A task of the monitor periodically checks the high water mark of every
+ * task, and logs a warning to sys_log whenever the free stack of a task
+ * drops to a new low under the margin.
+ *
+ * Requires configUSE_TRACE_FACILITY.
+ */
+class stack_monitor
+{
+public:
+	/// Largest number of tasks that are checked.
+	static constexpr size_t max_tasks = GPICO_STACK_MONITOR_MAX_TASKS;
+
+	stack_monitor() = default;
+
+	stack_monitor(const stack_monitor&) = delete;
+	stack_monitor& operator=(const stack_monitor&) = delete;
+
+	/** Starts the monitor task.
+	 *
+	 * Must be called once.
+	 *
+	 * @param[in] period Time between checks.
+	 * @param[in] priority Priority of the monitor task.
+	 * @param[in] margin_words Free stack, in words, under which to warn.
+	 */
+	void start(TickType_t period, UBaseType_t priority, uint32_t margin_words = 32);
+
+private:
+	struct low_mark
+	{
+		TaskHandle_t task;
+		uint32_t free_words;
+	};
+
+	TickType_t period_ = 0;
+	uint32_t margin_words_ = 0;
+	std::array<TaskStatus_t, max_tasks> status_;
+	std::array<task_stack, max_tasks> stacks_;
+	// Lowest mark warned about of each task, tasks gone are dropped
+	std::array<low_mark, max_tasks> warned_ = {};
+	size_t warned_count_ = 0;
+
+	static_task<256> task_;
+
+	void check();
+
+	static void monitor(void *param);
+};
+
+}
+
+#endif//GPICO_STACK_MONITOR_H_
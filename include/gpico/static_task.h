@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_STATIC_TASK_H_
+#define GPICO_STATIC_TASK_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <array>
+#include <cstddef>
+
+namespace gpico
+{
+
+/** FreeRTOS task with statically allocated control block and stack.
+ *
+ * Objects with static storage duration put all of the memory of the task in
+ * .bss, so it is accounted for at link time and creating the task can't fail.
+ *
+ * @tparam StackWords Size of the stack of the task, in words.
+ */
+template<size_t StackWords>
+class static_task
+{
+public:
+	/// Size of the stack of the task, in words.
+	static constexpr size_t stack_words = StackWords;
+
+	constexpr static_task() = default;
+
+	static_task(const static_task&) = delete;
+	static_task& operator=(const static_task&) = delete;
+
+	/** Creates the task.
+	 *
+	 * The memory of the task is only used once, so only the first call
+	 * creates it, even if several tasks or cores race to create it.
+	 *
+	 * @param[in] func Entry point of the task.
+	 * @param[in] name Name of the task.
+	 * @param[in] param Parameter passed to func.
+	 * @param[in] priority Priority of the task.
+	 * @param[in] affinity Cores the task may run on, as a bitmask. Ignored
+	 *  unless configUSE_CORE_AFFINITY is set.
+	 *
+	 * @returns The handle of the task, or null if it was already created.
+	 */
+	TaskHandle_t create(
+		TaskFunction_t func,
+		const char *name,
+		void *param,
+		UBaseType_t priority,
+		[[maybe_unused]] UBaseType_t affinity = tskNO_AFFINITY)
+	{
+		taskENTER_CRITICAL();
+		const bool created = created_;
+		created_ = true;
+		taskEXIT_CRITICAL();
+		if (created)
+			return nullptr;
+
+#if (configUSE_CORE_AFFINITY == 1) && (configNUMBER_OF_CORES > 1)
+		handle_ = xTaskCreateStaticAffinitySet(func, name, stack_.size(), param,
+			priority, stack_.data(), &tcb_, affinity);
+#else
+		handle_ = xTaskCreateStatic(func, name, stack_.size(), param,
+			priority, stack_.data(), &tcb_);
+#endif
+		return handle_;
+	}
+
+	/** Returns the handle of the task, or null if it hasn't been created.
+	 */
+	TaskHandle_t handle() const
+	{
+		return handle_;
+	}
+
+private:
+	StaticTask_t tcb_ = {};
+	std::array<StackType_t, StackWords> stack_ = {};
+	TaskHandle_t handle_ = nullptr;
+	bool created_ = false;
+};
+
+}
+
+#endif//GPICO_STATIC_TASK_H_
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_SYSCALLS_H_
+#define GPICO_SYSCALLS_H_
+
+#include <gpico/io_device.h>
+
+#ifndef GPICO_MAX_FILES
+#define GPICO_MAX_FILES 16
+#endif
+
+#ifndef GPICO_MAX_DEVICES
+#define GPICO_MAX_DEVICES 8
+#endif
+
+namespace gpico
+{
+	/** Registers a device, so files under the given path prefix are opened
+	 *  through it.
+	 *
+	 * A path belongs to the device registered with the longest prefix that
+	 * matches it as a whole path component, e.g. "/fs" matches "/fs" and
+	 * "/fs/log.txt", but not "/fsx". The device is passed the rest of the path
+	 * (e.g. "/log.txt", or "" when the prefix itself is opened).
+	 *
+	 * @param[in] prefix Path prefix, e.g. "/dev/cdc1" or "/fs". The string is
+	 *  not copied, so it must outlive the registration.
+	 * @param[in,out] device Device to open files through. Must outlive the
+	 *  registration.
+	 *
+	 * @returns True on success, false if the prefix is already registered or
+	 *  there is no room for more devices (see GPICO_MAX_DEVICES).
+	 */
+	bool register_device(const char *prefix, io_device& device);
+
+	/** Unregisters the device registered with the given prefix.
+	 *
+	 * Files already opened through the device remain open.
+	 *
+	 * @param[in] prefix Path prefix the device was registered with.
+	 *
+	 * @returns True on success, false if no device uses the prefix.
+	 */
+	bool unregister_device(const char *prefix);
+}
+
+#endif//GPICO_SYSCALLS_H_
@@ -8,25 +8,253 @@
 #include <FreeRTOS.h>
 #include <semphr.h>
 
+#include <pico.h>
+#include <pico/time.h>
+
+#include <gpico/crc.h>
+#include <gpico/lock.h>
+
 #include <sys/time.h>
 
-#include <deque>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <new>
 #include <string_view>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
+#include <type_traits>
+
+#ifndef GPICO_LOG_MIN_LEVEL
+#define GPICO_LOG_MIN_LEVEL 0
+#endif
+
+#ifndef GPICO_LOG_MAX_MODULE_FILTERS
+#define GPICO_LOG_MAX_MODULE_FILTERS 8
+#endif
 
 namespace gpico
 {
+	/** Severity of a log entry, from least to most severe.
+	 */
+	enum class log_level : uint8_t
+	{
+		debug,
+		info,
+		notice,
+		warning,
+		error,
+		critical,
+	};
+
+	/** Minimum log level compiled into the application.
+	 *
+	 * Set through the GPICO_LOG_MIN_LEVEL CMake cache variable. Logging calls
+	 * made through gpico::log with a lower level compile to nothing.
+	 */
+	constexpr log_level min_log_level =
+		static_cast<log_level>(GPICO_LOG_MIN_LEVEL);
+
+	/** Returns a human readable name for the given log level.
+	 *
+	 * @param[in] level Level to get the name of.
+	 *
+	 * @returns The name of the level.
+	 */
+	constexpr std::string_view to_string(log_level level)
+	{
+		constexpr std::array<std::string_view, 6> names{{
+			"debug", "info", "notice", "warning", "error", "critical"
+		}};
+		const size_t index = static_cast<size_t>(level);
+		return index < names.size() ? names[index] : "unknown";
+	}
+
+	/** Runtime filter of log entries by level and module.
+	 *
+	 * Checking the filter does not take any locks, so it is cheap enough to do
+	 * before formatting a message. Module names are compared by contents, so
+	 * the same tag used from different translation units matches.
+	 */
+	class log_filter
+	{
+	public:
+		/** Checks whether an entry of the given level and module passes the
+		 *  filter.
+		 *
+		 * @param[in] level Level of the entry.
+		 * @param[in] module Module tag of the entry, may be null.
+		 *
+		 * @returns True if the entry should be logged, false otherwise.
+		 */
+		bool enabled(log_level level, const char *module) const
+		{
+			if (level < min_log_level)
+				return false;
+			log_level threshold = default_level_.load(std::memory_order_relaxed);
+			if (module && modules_set_.load(std::memory_order_acquire))
+			{
+				for (const auto& filter : modules_)
+				{
+					const char *name = filter.name.load(std::memory_order_acquire);
+					if (name && std::strcmp(name, module) == 0)
+					{
+						threshold = filter.level.load(std::memory_order_relaxed);
+						break;
+					}
+				}
+			}
+			return level >= threshold;
+		}
+
+		/** Sets the minimum level logged for entries without a module
+		 *  specific filter.
+		 *
+		 * @param[in] level New default minimum level.
+		 */
+		void set_level(log_level level)
+		{
+			default_level_.store(level, std::memory_order_relaxed);
+		}
+
+		/** Sets the minimum level logged for the given module.
+		 *
+		 * @param[in] module Module tag to filter. The string must outlive the
+		 *  filter, which is the case for string literals.
+		 * @param[in] level New minimum level for the module.
+		 *
+		 * @returns True on success, false if there are no free module filter
+		 *  slots left.
+		 */
+		bool set_level(const char *module, log_level level)
+		{
+			bool result = false;
+			taskENTER_CRITICAL();
+			module_filter *free_slot = nullptr;
+			for (auto& filter : modules_)
+			{
+				const char *name = filter.name.load(std::memory_order_relaxed);
+				if (name && std::strcmp(name, module) == 0)
+				{
+					filter.level.store(level, std::memory_order_relaxed);
+					result = true;
+					break;
+				}
+				if (!name && !free_slot)
+					free_slot = &filter;
+			}
+			if (!result && free_slot)
+			{
+				free_slot->level.store(level, std::memory_order_relaxed);
+				free_slot->name.store(module, std::memory_order_release);
+				modules_set_.store(true, std::memory_order_release);
+				result = true;
+			}
+			taskEXIT_CRITICAL();
+			return result;
+		}
+
+	private:
+		struct module_filter
+		{
+			std::atomic<const char*> name = nullptr;
+			std::atomic<log_level> level = log_level::debug;
+		};
+
+		std::atomic<log_level> default_level_ = log_level::debug;
+		std::atomic_bool modules_set_ = false;
+		std::array<module_filter, GPICO_LOG_MAX_MODULE_FILTERS> modules_;
+	};
+
+	/** View of a single entry in a syslog.
+	 *
+	 * The record refers to the storage inside of the log, so it is only valid
+	 * while the log is not being modified.
+	 */
+	struct log_entry
+	{
+		/// Contents of the log entry.
+		std::string_view record;
+		/// Monotonic time at which the entry was added, in microseconds since
+		/// boot.
+		uint64_t timestamp;
+		/// Time at which the entry was added, which is the timestamp shifted
+		/// by the time offset of the log.
+		timeval time;
+		/// Sequence number of the entry, starting at 0 and incremented by one
+		/// for every entry pushed to the log.
+		uint64_t sequence;
+		/// Severity of the entry.
+		log_level level;
+		/// Module tag of the entry, or null if it has none.
+		const char *module;
+	};
+
+	/** Result of reading a syslog from a cursor.
+	 */
+	struct log_cursor
+	{
+		/// Sequence number to use as the cursor for the next read.
+		uint64_t next;
+		/// Number of entries between the requested cursor and the oldest
+		/// entry still in the log, which were evicted before they could be
+		/// read.
+		uint64_t dropped;
+	};
+
 	/** System log class.
 	 *
-	 * @tparam max_size The maximum size in bytes of the log in memory.
+	 * Entries are stored back to back in a ring buffer held inside of the
+	 * object itself, with the oldest entries evicted to make room for new
+	 * ones. As there are no heap allocations, where the object is placed
+	 * determines where the log lives in memory.
+	 *
+	 * A persistent log additionally keeps a CRC protected copy of its
+	 * bookkeeping and a CRC per entry. If the object is placed in memory that
+	 * is not cleared on boot (such as the .uninitialized_data section), the
+	 * constructor validates and recovers the entries logged before a warm
+	 * reset, such as a watchdog reset.
+	 *
+	 * @tparam max_size The maximum size in bytes of the log in memory,
+	 *  including the per-entry bookkeeping.
+	 * @tparam persistent Whether the log should survive resets.
 	 */
-	template<size_t max_size>
+	template<size_t max_size, bool persistent = false>
 	class syslog
 	{
 	public:
-		/** Add the given string to the log.
+		/** Constructor.
+		 *
+		 * If the log is persistent and the object still holds a valid log
+		 * from before a reset, the entries from it are kept. Otherwise the
+		 * log starts empty.
+		 */
+		syslog()
+		{
+			if constexpr (persistent)
+			{
+				if (recover())
+					return;
+			}
+			state_.next_sequence = 0;
+			clear();
+		}
+
+		syslog(const syslog&) = delete;
+		syslog& operator=(const syslog&) = delete;
+
+		/** Returns the length of the longest string an entry can hold.
+		 */
+		static constexpr size_t max_length()
+		{
+			return capacity - sizeof(header);
+		}
+
+		/** Add the given string to the log, at info level with no module.
 		 *
 		 * If a print callback is registered, this function will forward the
 		 * string to it as well.
@@ -35,20 +263,45 @@ namespace gpico
 		 */
 		void push(std::string_view str)
 		{
-			const size_t needed = str.size() + sizeof(log);
-			if (needed > max_size)
+			push(log_level::info, nullptr, str);
+		}
+
+		/** Add the given string to the log, if it passes the log filter.
+		 *
+		 * If a print callback is registered, this function will forward the
+		 * string to it as well.
+		 *
+		 * @param[in] level Severity of the entry.
+		 * @param[in] module Module tag of the entry, or null. The string must
+		 *  outlive the log, which is the case for string literals.
+		 * @param[in] str String to store in log.
+		 */
+		void push(log_level level, const char *module, std::string_view str)
+		{
+			if (!filter_.enabled(level, module))
+				return;
+
+			const size_t needed = entry_size(str.size());
+			if (needed > capacity)
 				return; // FIXME return some kind of error?
 
-			while (logs_.size() && needed > space_available_)
-			{
-				space_available_ += (logs_.front().record.size() + sizeof(log));
-				logs_.pop_front();
-			}
+			// The evictions are committed before the new entry overwrites
+			// them, so a persistent log is consistent at every point
+			if (make_room(needed))
+				commit();
 
-			space_available_ -= needed;
-			timeval tm;
-			gettimeofday(&tm, nullptr);
-			logs_.emplace_back(std::string(str), std::move(tm));
+			std::byte *location = buffer_.data() + state_.tail;
+			header *head = new (location) header{
+				time_us_64(), state_.next_sequence++, module,
+				static_cast<uint32_t>(str.size()), level, 0};
+			std::memcpy(location + sizeof(header), str.data(), str.size());
+			if constexpr (persistent)
+				head->crc = entry_crc(*head, str);
+			state_.last = state_.tail;
+			state_.tail += needed;
+			state_.used += needed;
+			++state_.count;
+			commit();
 
 			if (callback_)
 			{
@@ -56,13 +309,51 @@ namespace gpico
 			}
 		}
 
+		/** Removes all entries from the log.
+		 *
+		 * Sequence numbers keep counting up from where they were.
+		 */
+		void clear()
+		{
+			state_.head = 0;
+			state_.tail = 0;
+			state_.wrap = capacity;
+			state_.last = 0;
+			state_.used = 0;
+			state_.count = 0;
+			commit();
+		}
+
+		/** Returns the number of entries recovered from before the last reset.
+		 *
+		 * These are the entries with a sequence number lower than
+		 * boot_sequence(). Always 0 if the log is not persistent.
+		 *
+		 * @returns The number of entries recovered when the log was
+		 *  constructed.
+		 */
+		size_t recovered() const
+		{
+			return recovered_;
+		}
+
+		/** Returns the sequence number of the first entry pushed since the log
+		 *  was constructed.
+		 *
+		 * @returns The first sequence number of this boot.
+		 */
+		uint64_t boot_sequence() const
+		{
+			return boot_sequence_;
+		}
+
 		/** Returns the current number of log lines.
 		 *
 		 * @returns The number of lines in the log.
 		 */
 		size_t size() const
 		{
-			return logs_.size();
+			return state_.count;
 		}
 
 		/** Returns the size of the log in bytes.
@@ -71,7 +362,7 @@ namespace gpico
 		 */
 		size_t bytes() const
 		{
-			return max_size - space_available_;
+			return state_.used;
 		}
 
 		/** Returns the log at the given position.
@@ -83,13 +374,176 @@ namespace gpico
 		 */
 		std::string operator[](size_t index) const
 		{
-			auto& log = logs_[index];
-			std::string decimal = std::to_string(log.time.tv_usec);
+			std::string result;
+			read_since(first_sequence() + index, [&](const log_entry& entry) {
+				result = format(entry);
+				return false;
+			});
+			return result;
+		}
+
+		/** Formats a log entry for display.
+		 *
+		 * @param[in] entry Entry to format.
+		 *
+		 * @returns A string of the form
+		 *  "[seconds].[microseconds] [level] [module]: [record]", without the
+		 *  module part if the entry has no module.
+		 */
+		static std::string format(const log_entry& entry)
+		{
+			std::string decimal = std::to_string(entry.time.tv_usec);
 			// Build a string of the form of:
-			// [seconds].[decimals, 6 digits] - [log  contents]
-			return std::to_string(log.time.tv_sec) + "." +
-				std::string(6u - std::min(6u, decimal.length()), '0') +
-				decimal + " - " + log.record;
+			// [seconds].[decimals, 6 digits] [level] [module]: [log  contents]
+			std::string result = std::to_string(entry.time.tv_sec) + "." +
+				std::string(6u - std::min<size_t>(6u, decimal.length()), '0') +
+				decimal + " " + std::string(to_string(entry.level));
+			if (entry.module)
+			{
+				result += " ";
+				result += entry.module;
+			}
+			result += ": ";
+			result += entry.record;
+			return result;
+		}
+
+		/** Sets the offset added to entry timestamps when they are read.
+		 *
+		 * Entries always store the monotonic time since boot, so changing
+		 * the offset affects all entries, old and new.
+		 *
+		 * @param[in] offset Offset in microseconds to add to timestamps.
+		 */
+		void set_time_offset(int64_t offset)
+		{
+			time_offset_ = offset;
+		}
+
+		/** Returns the offset added to entry timestamps when they are read.
+		 *
+		 * @returns The offset in microseconds.
+		 */
+		int64_t time_offset() const
+		{
+			return time_offset_;
+		}
+
+		/** Sets the time offset so that entries are reported in wall-clock
+		 *  time, as given by gettimeofday right now.
+		 *
+		 * Call this after the wall-clock is set (e.g. after getting the time
+		 * from NTP) to get wall-clock times out of the log.
+		 */
+		void sync_time_offset()
+		{
+			timeval tm;
+			gettimeofday(&tm, nullptr);
+			const int64_t now = static_cast<int64_t>(tm.tv_sec) * 1'000'000 + tm.tv_usec;
+			time_offset_ = now - static_cast<int64_t>(time_us_64());
+		}
+
+		/** Returns the runtime filter of this log.
+		 *
+		 * @returns The filter applied to entries pushed to this log.
+		 */
+		log_filter& filter()
+		{
+			return filter_;
+		}
+
+		/** Returns the runtime filter of this log.
+		 *
+		 * @returns The filter applied to entries pushed to this log.
+		 */
+		const log_filter& filter() const
+		{
+			return filter_;
+		}
+
+		/** Returns the sequence number of the oldest entry in the log.
+		 *
+		 * If the log is empty, this is the same as next_sequence().
+		 *
+		 * @returns The sequence number of the oldest entry in the log.
+		 */
+		uint64_t first_sequence() const
+		{
+			return state_.next_sequence - state_.count;
+		}
+
+		/** Returns the sequence number the next pushed entry will get.
+		 *
+		 * @returns The sequence number of the next entry.
+		 */
+		uint64_t next_sequence() const
+		{
+			return state_.next_sequence;
+		}
+
+		/** Visits every entry in the log, from oldest to newest, in place.
+		 *
+		 * @tparam Func Function or functor taking a const log_entry&. If it
+		 *  returns bool, returning false stops the iteration.
+		 *
+		 * @param[in] func Function to call for every entry.
+		 */
+		template<class Func>
+		void for_each(Func&& func) const
+		{
+			read_since(first_sequence(), std::forward<Func>(func));
+		}
+
+		/** Visits the entries with a sequence number of at least the given
+		 *  cursor, from oldest to newest, in place.
+		 *
+		 * This is meant for consumers that follow the log: start with a
+		 * cursor of 0 (or next_sequence() to skip the current contents), and
+		 * pass the returned next cursor on the next call to only get new
+		 * entries.
+		 *
+		 * @tparam Func Function or functor taking a const log_entry&. If it
+		 *  returns bool, returning false stops the iteration, and the returned
+		 *  cursor points at the entry that was rejected.
+		 *
+		 * @param[in] cursor Sequence number of the first entry to visit.
+		 * @param[in] func Function to call for every entry.
+		 *
+		 * @returns The cursor for the next read, and how many entries were
+		 *  evicted from the log before they could be visited.
+		 */
+		template<class Func>
+		log_cursor read_since(uint64_t cursor, Func&& func) const
+		{
+			const uint64_t first = first_sequence();
+			log_cursor result{std::max(cursor, first), 0};
+			if (cursor < first)
+				result.dropped = first - cursor;
+
+			size_t offset = state_.head;
+			for (size_t i = 0; i < state_.count; ++i)
+			{
+				const header& head = at(offset);
+				const size_t current = offset;
+				offset += entry_size(head.length);
+				if (offset == state_.wrap)
+					offset = 0;
+				if (head.sequence < result.next)
+					continue;
+
+				const log_entry entry = get(current);
+				if constexpr (std::is_same_v<std::invoke_result_t<Func&, const log_entry&>, bool>)
+				{
+					if (!func(entry))
+						break;
+				}
+				else
+				{
+					func(entry);
+				}
+				++result.next;
+			}
+			return result;
 		}
 
 		/** Returns the last log inserted.
@@ -100,7 +554,7 @@ namespace gpico
 		 */
 		std::string_view back() const
 		{
-			return logs_.back();
+			return get(state_.last).record;
 		}
 
 		/** Registers a callback function that is called every time a log entry
@@ -126,80 +580,447 @@ namespace gpico
 		}
 
 	private:
-		struct log {
-			std::string record;
-			timeval time;
+		// Bookkeeping stored in the buffer in front of every record
+		struct header {
+			uint64_t timestamp;
+			uint64_t sequence;
+			const char *module;
+			uint32_t length;
+			log_level level;
+			uint32_t crc;
+		};
+
+		// Position of the entries in the buffer. The buffer is either
+		// contiguous, with entries in [head, tail), or wrapped, with entries in
+		// [head, wrap) followed by [0, tail).
+		struct ring_state {
+			size_t head;
+			size_t tail;
+			size_t wrap;
+			size_t last;
+			size_t used;
+			size_t count;
+			uint64_t next_sequence;
+		};
+
+		// Copy of the ring state kept alongside the buffer by persistent logs.
+		// Two copies are alternated, so a reset in the middle of a commit
+		// leaves the previous one intact.
+		struct saved_state {
+			uint32_t magic;
+			uint32_t generation;
+			ring_state state;
+			uint32_t crc;
 		};
-		size_t space_available_ = max_size;
-		std::deque<log> logs_;
+
+		static constexpr size_t alignment = alignof(header);
+		static constexpr size_t capacity = max_size / alignment * alignment;
+		static_assert(capacity >= sizeof(header), "syslog max_size is too small");
+		static constexpr uint32_t magic =
+			0x676c'6f67u ^ static_cast<uint32_t>(capacity) ^ (sizeof(header) << 24);
+
+		// For persistent logs, the buffer, saved states, and ring state are
+		// deliberately left alone until the constructor body runs, so they
+		// survive a reset
+		alignas(alignment) std::array<std::byte, capacity> buffer_;
+		std::array<saved_state, persistent ? 2 : 0> saved_;
+		ring_state state_;
+		uint32_t generation_ = 0;
+		uint64_t boot_sequence_ = 0;
+		size_t recovered_ = 0;
+		int64_t time_offset_ = 0;
 		std::function<void(std::string_view)> callback_;
+		log_filter filter_;
+
+		static constexpr size_t entry_size(size_t length)
+		{
+			return (sizeof(header) + length + alignment - 1) / alignment * alignment;
+		}
+
+		header& at(size_t offset)
+		{
+			return *std::launder(reinterpret_cast<header*>(buffer_.data() + offset));
+		}
+
+		const header& at(size_t offset) const
+		{
+			return *std::launder(reinterpret_cast<const header*>(buffer_.data() + offset));
+		}
+
+		std::string_view record(size_t offset) const
+		{
+			const char *record = reinterpret_cast<const char*>(
+				buffer_.data() + offset + sizeof(header));
+			return std::string_view(record, at(offset).length);
+		}
+
+		log_entry get(size_t offset) const
+		{
+			const header& head = at(offset);
+			const int64_t time = static_cast<int64_t>(head.timestamp) + time_offset_;
+			int64_t seconds = time / 1'000'000;
+			int64_t microseconds = time % 1'000'000;
+			if (microseconds < 0)
+			{
+				seconds -= 1;
+				microseconds += 1'000'000;
+			}
+			timeval tm;
+			tm.tv_sec = static_cast<time_t>(seconds);
+			tm.tv_usec = static_cast<suseconds_t>(microseconds);
+			return log_entry{
+				record(offset), head.timestamp, tm, head.sequence, head.level,
+				head.module};
+		}
+
+		static uint32_t entry_crc(const header& head, std::string_view str)
+		{
+			// Go field by field, as the header has padding
+			uint32_t crc = crc32(head.timestamp);
+			crc = crc32(head.sequence, crc);
+			crc = crc32(head.module, crc);
+			crc = crc32(head.length, crc);
+			crc = crc32(head.level, crc);
+			return crc32(std::as_bytes(std::span(str.data(), str.size())), crc);
+		}
+
+		static uint32_t saved_crc(const saved_state& saved)
+		{
+			return crc32(std::span(
+				reinterpret_cast<const std::byte*>(&saved),
+				offsetof(saved_state, crc)));
+		}
+
+		// Saves the ring state for recovery after a reset, if persistent
+		void commit()
+		{
+			if constexpr (persistent)
+			{
+				saved_state& saved = saved_[++generation_ & 1];
+				saved.magic = magic;
+				saved.generation = generation_;
+				saved.state = state_;
+				saved.crc = saved_crc(saved);
+			}
+		}
+
+		// Rebuilds the ring state from the newest valid saved state, keeping
+		// every entry up to the first one that fails validation
+		bool recover()
+		{
+			const saved_state *saved = nullptr;
+			for (const saved_state& candidate : saved_)
+			{
+				if (candidate.magic != magic || candidate.crc != saved_crc(candidate))
+					continue;
+				if (!saved || static_cast<int32_t>(candidate.generation - saved->generation) > 0)
+					saved = &candidate;
+			}
+			if (!saved)
+				return false;
+
+			const ring_state old = saved->state;
+			const bool wrapped = old.count && old.tail <= old.head;
+			if (old.head >= capacity || old.tail > capacity || old.count > capacity ||
+				(wrapped && (old.wrap > capacity || old.wrap < old.head)))
+			{
+				return false;
+			}
+
+			generation_ = saved->generation;
+			state_.head = old.head;
+			state_.tail = old.head;
+			state_.wrap = capacity;
+			state_.last = old.head;
+			state_.used = 0;
+			state_.count = 0;
+			state_.next_sequence = old.next_sequence - old.count;
+
+			// Replay the entries in order, moving to the start of the buffer
+			// once the end of the upper part of a wrapped buffer is reached
+			size_t end = wrapped ? old.wrap : old.tail;
+			bool lower = false;
+			for (size_t i = 0; i < old.count; ++i)
+			{
+				if (wrapped && !lower && state_.tail == end)
+				{
+					lower = true;
+					state_.wrap = end;
+					state_.tail = 0;
+					end = old.tail;
+				}
+
+				const size_t offset = state_.tail;
+				if (offset + sizeof(header) > end)
+					break;
+				header& head = at(offset);
+				const size_t size = entry_size(head.length);
+				if (head.length > capacity || offset + size > end ||
+					head.sequence != state_.next_sequence ||
+					head.crc != entry_crc(head, record(offset)))
+				{
+					break;
+				}
+
+				// Module tags are only trusted if they point to flash, as
+				// the firmware may have changed across the reset
+				const auto module = reinterpret_cast<uintptr_t>(head.module);
+				if (module && (module < XIP_BASE ||
+					module >= XIP_BASE + PICO_FLASH_SIZE_BYTES))
+				{
+					head.module = nullptr;
+					head.crc = entry_crc(head, record(offset));
+				}
+
+				state_.last = offset;
+				state_.tail += size;
+				state_.used += size;
+				++state_.count;
+				++state_.next_sequence;
+			}
+
+			// If the walk stopped right after wrapping, nothing was kept from
+			// the start of the buffer, so go back to a contiguous buffer
+			if (lower && state_.tail == 0)
+			{
+				state_.tail = state_.wrap;
+				state_.wrap = capacity;
+			}
+
+			if (state_.count == 0)
+				clear();
+			else
+				commit();
+			boot_sequence_ = state_.next_sequence;
+			recovered_ = state_.count;
+			return true;
+		}
+
+		void pop_front()
+		{
+			const size_t size = entry_size(at(state_.head).length);
+			state_.head += size;
+			state_.used -= size;
+			--state_.count;
+			if (state_.head == state_.wrap)
+			{
+				state_.head = 0;
+				state_.wrap = capacity;
+			}
+		}
+
+		// Evicts the oldest entries until there are needed contiguous bytes
+		// free at the tail, wrapping the tail to the start of the buffer if
+		// the end of the buffer is too small. Returns whether the state
+		// changed.
+		bool make_room(size_t needed)
+		{
+			bool changed = false;
+			for (;;)
+			{
+				if (state_.count == 0)
+				{
+					changed = changed || state_.tail != 0;
+					state_.head = state_.tail = 0;
+					state_.wrap = capacity;
+					return changed;
+				}
+
+				if (state_.tail > state_.head)
+				{
+					if (state_.tail + needed <= capacity)
+						return changed;
+					state_.wrap = state_.tail;
+					state_.tail = 0;
+				}
+				else if (state_.tail + needed <= state_.head)
+				{
+					return changed;
+				}
+				else
+				{
+					pop_front();
+				}
+				changed = true;
+			}
+		}
 	};
 
 	/** Wrapper around syslog to make it thread-safe.
 	 *
-	 * Uses a FreeRTOS mutex to limit access to one task at a time.
+	 * Uses a gpico::mutex to limit access to one task at a time, which keeps
+	 * lock statistics under the name "sys_log" with GPICO_LOCK_STATS.
 	 */
 	template<class syslog>
 	class safe_syslog
 	{
 	public:
 		safe_syslog()
+		:mutex_("sys_log")
+		{}
+
+		/** Returns the length of the longest string an entry can hold.
+		 */
+		static constexpr size_t max_length()
 		{
-			mutex_ = xSemaphoreCreateBinaryStatic(&mutex_buffer_);
-			xSemaphoreGive(mutex_);
+			return syslog::max_length();
 		}
 
-		void push(std::string_view&& str)
+		void push(std::string_view str)
 		{
-			xSemaphoreTake(mutex_, portMAX_DELAY);
+			unique_lock<mutex> lock(mutex_);
 			log_.push(str);
-			xSemaphoreGive(mutex_);
+		}
+
+		void push(log_level level, const char *module, std::string_view str)
+		{
+			// Check the filter before taking the lock, it is lock-free
+			if (!enabled(level, module))
+				return;
+			unique_lock<mutex> lock(mutex_);
+			log_.push(level, module, str);
+		}
+
+		/** Checks whether an entry would pass the log filter, without taking
+		 *  the lock.
+		 *
+		 * @see log_filter::enabled
+		 */
+		bool enabled(log_level level, const char *module) const
+		{
+			return log_.filter().enabled(level, module);
+		}
+
+		void clear()
+		{
+			unique_lock<mutex> lock(mutex_);
+			log_.clear();
+		}
+
+		size_t recovered() const
+		{
+			unique_lock<mutex> lock(mutex_);
+			size_t result = log_.recovered();
+			return result;
+		}
+
+		uint64_t boot_sequence() const
+		{
+			unique_lock<mutex> lock(mutex_);
+			uint64_t result = log_.boot_sequence();
+			return result;
+		}
+
+		void set_time_offset(int64_t offset)
+		{
+			unique_lock<mutex> lock(mutex_);
+			log_.set_time_offset(offset);
+		}
+
+		int64_t time_offset() const
+		{
+			unique_lock<mutex> lock(mutex_);
+			int64_t result = log_.time_offset();
+			return result;
+		}
+
+		void sync_time_offset()
+		{
+			unique_lock<mutex> lock(mutex_);
+			log_.sync_time_offset();
+		}
+
+		/** Returns the runtime filter of the log.
+		 *
+		 * The filter is safe to use without holding the lock.
+		 */
+		log_filter& filter()
+		{
+			return log_.filter();
 		}
 
 		size_t size() const
 		{
-			xSemaphoreTake(mutex_, portMAX_DELAY);
+			unique_lock<mutex> lock(mutex_);
 			size_t result = log_.size();
-			xSemaphoreGive(mutex_);
 			return result;
 		}
 
 		size_t bytes() const
 		{
-			xSemaphoreTake(mutex_, portMAX_DELAY);
-			size_t result = log_.bytes_();
-			xSemaphoreGive(mutex_);
+			unique_lock<mutex> lock(mutex_);
+			size_t result = log_.bytes();
 			return result;
 		}
 
 		std::string operator[](size_t index) const
 		{
-			xSemaphoreTake(mutex_, portMAX_DELAY);
+			unique_lock<mutex> lock(mutex_);
 			std::string result = std::string(log_[index]);
-			xSemaphoreGive(mutex_);
 			return result;
 		}
 
 		std::string back() const
 		{
-			xSemaphoreTake(mutex_, portMAX_DELAY);
-			std::string result = log_.back();
-			xSemaphoreGive(mutex_);
+			unique_lock<mutex> lock(mutex_);
+			std::string result(log_.back());
+			return result;
+		}
+
+		uint64_t first_sequence() const
+		{
+			unique_lock<mutex> lock(mutex_);
+			uint64_t result = log_.first_sequence();
+			return result;
+		}
+
+		uint64_t next_sequence() const
+		{
+			unique_lock<mutex> lock(mutex_);
+			uint64_t result = log_.next_sequence();
+			return result;
+		}
+
+		/** Visits every entry in the log while holding the lock once.
+		 *
+		 * The function must not push to this log, and should be short, as
+		 * every other user of the log is blocked until the iteration is done.
+		 *
+		 * @see syslog::for_each
+		 */
+		template<class Func>
+		void for_each(Func&& func) const
+		{
+			unique_lock<mutex> lock(mutex_);
+			log_.for_each(std::forward<Func>(func));
+		}
+
+		/** Visits every entry since the given cursor while holding the lock
+		 *  once.
+		 *
+		 * The function must not push to this log, and should be short, as
+		 * every other user of the log is blocked until the iteration is done.
+		 *
+		 * @see syslog::read_since
+		 */
+		template<class Func>
+		log_cursor read_since(uint64_t cursor, Func&& func) const
+		{
+			unique_lock<mutex> lock(mutex_);
+			log_cursor result = log_.read_since(cursor, std::forward<Func>(func));
 			return result;
 		}
 
 		template<class Func, class... Args>
 		void register_push_callback(Func&& func, Args&&... args)
 		{
-			xSemaphoreTake(mutex_, portMAX_DELAY);
+			unique_lock<mutex> lock(mutex_);
 			log_.register_push_callback(std::forward<Func>(func), std::forward<Args>(args)...);
-			xSemaphoreGive(mutex_);
 		}
 
 	private:
 		syslog log_;
-		StaticSemaphore_t mutex_buffer_;
-		SemaphoreHandle_t mutex_;
+		mutable mutex mutex_;
 	};
 }
 
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_TRACE_H_
+#define GPICO_TRACE_H_
+
+#include <gpico/freertos_hooks.h>
+#include <gpico/rpc.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef GPICO_TRACE
+#define GPICO_TRACE 0
+#endif
+
+#ifndef GPICO_TRACE_EVENTS
+#define GPICO_TRACE_EVENTS 512
+#endif
+
+namespace gpico
+{
+
+/** Types of the events in the trace buffer.
+ */
+enum class trace_type : uint8_t
+{
+	/// A task started running, object is the task.
+	switched_in = GPICO_TRACE_SWITCHED_IN,
+	/// A task stopped running, object is the task.
+	switched_out = GPICO_TRACE_SWITCHED_OUT,
+	/// A task became ready to run, object is the task.
+	task_ready = GPICO_TRACE_TASK_READY,
+	/// The running task blocked sending to a queue, object is the queue.
+	queue_block_send = GPICO_TRACE_QUEUE_BLOCK_SEND,
+	/// The running task blocked receiving from a queue, semaphore, or mutex,
+	/// object is the queue.
+	queue_block_receive = GPICO_TRACE_QUEUE_BLOCK_RECEIVE,
+	/// An interrupt handler started, object is the IRQ number.
+	isr_enter = GPICO_TRACE_ISR_ENTER,
+	/// An interrupt handler finished, object is the IRQ number.
+	isr_exit = GPICO_TRACE_ISR_EXIT,
+	/// Application-defined event, object is a 24-bit value.
+	user = GPICO_TRACE_USER,
+};
+
+/** Number of events kept per core.
+ *
+ * Older events are overwritten by newer ones.
+ */
+constexpr size_t trace_events = GPICO_TRACE_EVENTS;
+static_assert((trace_events & (trace_events - 1)) == 0 && trace_events <= 0x8000,
+	"GPICO_TRACE_EVENTS must be a power of 2, up to 32768");
+
+/** Records an event in the trace buffer of the current core.
+ *
+ * Safe to call from tasks and interrupt handlers. Does nothing unless gpico
+ * is built with GPICO_TRACE.
+ *
+ * @param[in] type Event type.
+ * @param[in] value Object or value the event refers to. Only the lower 24
+ *  bits are kept.
+ */
+inline void trace(trace_type type, uint32_t value)
+{
+	if constexpr (GPICO_TRACE)
+		gpico_trace_event(static_cast<uint32_t>(type),
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(value)));
+}
+
+/** Records the start of an interrupt handler.
+ *
+ * FreeRTOS has no interrupt hooks, so handlers to be traced call this on
+ * entry, and trace_isr_exit() on return.
+ *
+ * @param[in] irq IRQ number of the handler.
+ */
+inline void trace_isr_enter(unsigned irq)
+{
+	trace(trace_type::isr_enter, irq);
+}
+
+/** Records the end of an interrupt handler.
+ *
+ * @param[in] irq IRQ number of the handler.
+ */
+inline void trace_isr_exit(unsigned irq)
+{
+	trace(trace_type::isr_exit, irq);
+}
+
+/** Enables or disables recording of trace events.
+ *
+ * Recording is enabled from boot when gpico is built with GPICO_TRACE.
+ *
+ * @param[in] enable Whether to record events.
+ */
+void trace_enable(bool enable);
+
+/** Registers a method that dumps the trace buffers through a gpico::rpc
+ *  transport.
+ *
+ * The request payload is one optional byte of flags, with bit 0 set to
+ * clear the buffers after the dump. Recording is paused while the dump is
+ * sent. The dump is a sequence of stream frames, each starting with a record
+ * type byte (all integers little-endian):
+ *
+ *  - 0, header: {uint8_t cores; uint16_t events; uint32_t timer_hz;}, with
+ *    events being the number of events kept per core.
+ *  - 1, task: {uint8_t pad[3]; uint32_t task; char name[];}, one per task,
+ *    naming the task objects of the events.
+ *  - 2, events: {uint8_t core; uint16_t pad; uint32_t lost;} followed by the
+ *    events of a core, oldest first, each {uint32_t time; uint32_t data;},
+ *    with time in timer ticks (wrapping around), the type in the top 8 bits
+ *    of data and the object in the rest. lost is the number of events
+ *    overwritten before the dump.
+ *
+ * The response is {uint32_t events;}, the number of events sent.
+ * tools/gpico_trace.py converts dumps to the Chrome trace format, which
+ * Perfetto also opens.
+ *
+ * @param[in,out] transport Transport to register the method with.
+ * @param[in] id Method id.
+ *
+ * @returns True on success, false if the method could not be registered.
+ */
+bool register_trace_method(rpc& transport, uint8_t id = 0x20);
+
+}
+
+#endif//GPICO_TRACE_H_
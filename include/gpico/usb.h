@@ -2,16 +2,35 @@
 // SPDX-FileCopyrightText: Gabriel Marcano, 2025
 /// @file
 
+#ifndef GPICO_USB_H_
+#define GPICO_USB_H_
+
 namespace gpico
 {
 
-/** Returns whether the USB CDC device is connected to a host or not.
+/** Returns whether the USB CDC device (interface 0) is connected to a host or
+ *  not.
  */
 bool usb_cdc_connected();
 
+/** Wakes up the USB task so it processes pending work, such as queued CDC
+ *  data.
+ *
+ * This is cheap to call often, as at most one wake up is pending at a time.
+ * Safe to call before the USB task starts, in which case it does nothing, as
+ * the task processes all pending work when it starts.
+ */
+void usb_task_wake();
+
 /** Initializes a FreeRTOS task to process USB events in Core 1 at a priority
  * level 2 higher than IDLE.
+ *
+ * If TinyUSB is configured to use FreeRTOS (CFG_TUSB_OS set to
+ * OPT_OS_FREERTOS), the task blocks on the TinyUSB event queue and only runs
+ * when there is work to do. Otherwise, it polls TinyUSB every tick.
  */
 void initialize_usb_task();
 
 }
+
+#endif//GPICO_USB_H_
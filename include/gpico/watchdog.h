@@ -5,18 +5,171 @@
 #ifndef GPICO_WATCHDOG_H_
 #define GPICO_WATCHDOG_H_
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#ifndef GPICO_MAX_HEARTBEATS
+#define GPICO_MAX_HEARTBEATS 16
+#endif
+
 namespace gpico
 {
 
 /** Initializes all of the watchdog tasks for the cores of the machine.
  *
  * For the rp2xxx, there are two cores, so each core gets its own dedicated
- * task, plus one central task.
+ * task, plus one central task. The central task only feeds the hardware
+ * watchdog while every registered heartbeat meets its deadline, including
+ * the ones of the per-core tasks.
+ *
+ * On every check, the central task leaves a record in watchdog scratch
+ * registers 0 to 3: the uptime, the first heartbeat that missed its deadline
+ * (if any), and the task running on each core. Where a watchdog task is
+ * running, the task it preempted is recorded instead, which needs the hooks
+ * of gpico/freertos_hooks.h. Tasks are recorded by handle, and named in the
+ * report if a task with the same handle exists again, as statically
+ * allocated ones do. If the previous reset was caused by the watchdog, this
+ * logs the record left to sys_log once the watchdog tasks are running.
  *
  * This _must_ be called from within a FreeRTOS task!
  */
 void initialize_watchdog_tasks();
 
+/** Clears the record left by the watchdog task in the watchdog scratch
+ *  registers.
+ *
+ * Used before intentional watchdog resets, so they are not reported as the
+ * watchdog firing on the next boot.
+ */
+void clear_watchdog_record();
+
+/** Replaces the record left by the watchdog task with one naming a task that
+ *  overflowed its stack.
+ *
+ * Called by vApplicationStackOverflowHook(). The record is kept until the
+ * watchdog resets the system, and reported on the next boot by
+ * initialize_watchdog_tasks().
+ *
+ * @param[in] task_name Name of the task, only the first 12 characters are
+ *  kept.
+ */
+void record_stack_overflow(const char *task_name);
+
+/** Timing statistics of a heartbeat.
+ *
+ * Jitter is how much later than its period a beat came, in microseconds.
+ */
+struct heartbeat_stats
+{
+	/// Number of beats so far.
+	uint32_t beats;
+	/// Largest jitter seen.
+	uint32_t max_jitter_us;
+	/// 99th percentile of the jitter, rounded up to a power of 2.
+	uint32_t p99_jitter_us;
+	/// Number of times the deadline was missed.
+	uint32_t missed_deadlines;
+};
+
+/** Heartbeat of a task, checked by the central watchdog task.
+ *
+ * The task owning the heartbeat calls beat() once per period. If more than
+ * the deadline passes without a beat, the watchdog task stops feeding the
+ * hardware watchdog, and the system resets. The heartbeat is registered
+ * while the object exists, so it can live on the stack of its task.
+ */
+class heartbeat
+{
+public:
+	/** Constructor, registers the heartbeat.
+	 *
+	 * @param[in] name Name of the heartbeat, e.g. of its task. The string is
+	 *  not copied.
+	 * @param[in] period_us Expected time between beats, in microseconds.
+	 * @param[in] deadline_us Longest time allowed between beats, in
+	 *  microseconds. Should leave room for the watchdog task to notice a
+	 *  missed deadline before the hardware watchdog expires.
+	 */
+	heartbeat(const char *name, uint32_t period_us, uint32_t deadline_us);
+
+	/** Destructor, unregisters the heartbeat.
+	 */
+	~heartbeat();
+
+	heartbeat(const heartbeat&) = delete;
+	heartbeat& operator=(const heartbeat&) = delete;
+
+	/** Records a beat, restarting the deadline.
+	 *
+	 * Must only be called by the task owning the heartbeat.
+	 */
+	void beat();
+
+	/** Returns whether the heartbeat was registered.
+	 *
+	 * Registration fails if there are already GPICO_MAX_HEARTBEATS
+	 * heartbeats. Heartbeats that are not registered are not checked.
+	 */
+	bool registered() const;
+
+	/** Returns the name of the heartbeat.
+	 */
+	const char *name() const;
+
+	/** Returns the timing statistics of the heartbeat so far.
+	 */
+	heartbeat_stats stats() const;
+
+	/** Returns whether more than the deadline has passed since the last
+	 *  beat.
+	 */
+	bool expired() const;
+
+	/** Clears the timing statistics.
+	 */
+	void reset_stats();
+
+private:
+	friend const heartbeat *watchdog_check_heartbeats();
+
+	const char *name_;
+	uint32_t period_us_;
+	uint32_t deadline_us_;
+	std::atomic<uint32_t> last_beat_us_;
+	bool registered_;
+	bool late_ = false;
+
+	// Statistics, updated in critical sections
+	uint32_t beats_ = 0;
+	uint32_t max_jitter_us_ = 0;
+	uint32_t missed_deadlines_ = 0;
+	// Histogram of jitter, bucket n counting values below 2^n
+	std::array<uint32_t, 33> jitter_histogram_ = {};
+};
+
+/** Snapshot of a registered heartbeat, see for_each_heartbeat().
+ */
+struct heartbeat_info
+{
+	/// Name of the heartbeat, the string passed to its constructor.
+	const char *name;
+	/// Timing statistics when the snapshot was taken.
+	heartbeat_stats stats;
+};
+
+/** Calls the given function with a snapshot of every registered heartbeat.
+ *
+ * The snapshots are taken with the registry locked, and the function is
+ * called after unlocking it, so the watchdog task keeps checking heartbeats
+ * while it runs, however long it takes. The function may register and
+ * unregister heartbeats.
+ *
+ * @param[in] func Function to call.
+ */
+void for_each_heartbeat(const std::function<void(const heartbeat_info&)>& func);
+
 }
 
 #endif//GPICO_WATCHDOG_H_
@@ -2,6 +2,11 @@
 // SPDX-FileCopyrightText: Gabriel Marcano, 2024
 /// @file
 
+#include <gpico/freertos_hooks.h>
+#include <gpico/watchdog.h>
+
+#include <pico/time.h>
+
 #include <FreeRTOS.h>
 #include <semphr.h>
 #include <timers.h>
@@ -38,8 +43,17 @@ void vApplicationGetTimerTaskMemory(StaticTask_t **timer_task_tcb, StackType_t *
 	*timer_stack_size = sizeof(task_stack)/sizeof(*task_stack);
 }
 
+uint64_t gpico_run_time_counter(void)
+{
+	return time_us_64();
+}
+
 void vApplicationStackOverflowHook(
-	TaskHandle_t /*xTask*/, char * /*pcTaskName*/)
+	TaskHandle_t /*xTask*/, char *pcTaskName)
 {
+	// The scheduler locks are held and the stack of the task is corrupt, so
+	// the offender can't be logged right away. Leave a record for the next
+	// boot instead, which the watchdog resetting the system reports.
+	gpico::record_stack_overflow(pcTaskName);
 	__asm volatile ("bkpt #0");
 }
@@ -3,24 +3,46 @@
 /// @file
 
 #include <gpico/cdc_device.h>
+#include <gpico/poll.h>
 #include <gpico/usb.h>
 
 #include <tusb.h>
 
-#include <span>
+#include <FreeRTOS.h>
+#include <event_groups.h>
+#include <stream_buffer.h>
+#include <task.h>
 
-#include <errno.h>
-#undef errno
-extern int errno;
+#include <algorithm>
+#include <cerrno>
+#include <array>
+#include <cstring>
+#include <span>
 
 namespace gpico
 {
 
 cdc_file_descriptor cdc_descriptor(gpico::cdc);
 
+// Devices indexed by interface number, for the USB task to service. Constant
+// initialized, so devices can register from their constructors regardless of
+// static initialization order.
+static std::array<cdc_device*, CFG_TUD_CDC> devices = {};
+
+cdc_device::cdc_device(uint8_t interface)
+:interface_(interface), descriptor_(*this)
+{
+	configASSERT(interface < CFG_TUD_CDC && !devices[interface]);
+	events_ = xEventGroupCreateStatic(&events_buffer_);
+	poll_bit_ = allocate_poll_bit();
+	tx_ = xStreamBufferCreateStatic(
+		tx_storage_.size() - 1, 1, tx_storage_.data(), &tx_buffer_);
+	devices[interface] = this;
+}
+
 bool cdc_device::probe()
 {
-	while(!usb_cdc_connected());
+	xEventGroupWaitBits(events_, event_connected, pdFALSE, pdTRUE, portMAX_DELAY);
 	return true;
 }
 
@@ -31,7 +53,22 @@ bool cdc_device::unload()
 
 std::expected<file_descriptor*, int> cdc_device::open(const char * /*path*/)
 {
-	return &cdc_descriptor;
+	return &descriptor_;
+}
+
+uint8_t cdc_device::interface() const
+{
+	return interface_;
+}
+
+bool cdc_device::connected() const
+{
+	return connected_;
+}
+
+EventGroupHandle_t cdc_device::events() const
+{
+	return events_;
 }
 
 cdc_file_descriptor::cdc_file_descriptor(cdc_device& device)
@@ -48,51 +85,282 @@ int cdc_file_descriptor::read(std::span<std::byte> buffer)
 	return device.read(buffer);
 }
 
+int cdc_file_descriptor::writev(std::span<const std::span<const std::byte>> buffers)
+{
+	return device.writev(buffers);
+}
+
+int cdc_file_descriptor::readv(std::span<const std::span<std::byte>> buffers)
+{
+	return device.readv(buffers);
+}
+
+uint8_t cdc_file_descriptor::poll_ready()
+{
+	return device.poll_ready();
+}
+
+EventBits_t cdc_file_descriptor::poll_bit()
+{
+	return device.poll_bit();
+}
+
 int cdc_device::write(std::span<const std::byte> data)
 {
-	if (!usb_cdc_connected())
+	return writev(std::span(&data, 1));
+}
+
+int cdc_device::writev(std::span<const std::span<const std::byte>> buffers)
+{
+	if (!connected_)
 	{
 		errno = ENXIO;
 		return -1;
 	}
 
-	if (tud_cdc_write_available() == 0)
+	size_t size = 0;
+	size_t sent = 0;
+	bool newline = false;
 	{
-		tud_task();
-		tud_cdc_write_flush();
+		unique_lock<mutex> lock(write_lock_);
+		for (auto data : buffers)
+		{
+			size += data.size();
+			size_t part = 0;
+			while (part < data.size())
+			{
+				part += xStreamBufferSend(
+					tx_, data.data() + part, data.size() - part, 0);
+				if (part == data.size())
+					break;
+
+				// The buffer is full, and the USB task only drains it when
+				// woken up, so wake it before waiting for room. Wake up
+				// periodically to notice if the host went away meanwhile
+				usb_task_wake();
+				part += xStreamBufferSend(
+					tx_, data.data() + part, data.size() - part, pdMS_TO_TICKS(100));
+				if (part < data.size() && !connected_)
+					break;
+			}
+
+			sent += part;
+			newline = newline || std::memchr(data.data(), '\n', part);
+			if (part < data.size())
+				break;
+		}
 	}
 
-	uint32_t result = tud_cdc_write(
-		reinterpret_cast<const unsigned char*>(data.data()), data.size());
-	tud_cdc_write_flush();
-	return static_cast<int>(result);
-}
+	if (flush_on_newline_ && newline)
+		flush_requested_ = true;
+	usb_task_wake();
 
-int cdc_device::read(std::span<std::byte> buffer)
-{
-	if (!usb_cdc_connected())
+	if (sent == 0 && size)
 	{
 		errno = ENXIO;
 		return -1;
 	}
+	return static_cast<int>(sent);
+}
+
+size_t cdc_device::write_available() const
+{
+	return xStreamBufferSpacesAvailable(tx_);
+}
+
+void cdc_device::flush()
+{
+	flush_requested_ = true;
+	usb_task_wake();
+}
+
+void cdc_device::set_flush_policy(const cdc_flush_policy& policy)
+{
+	flush_on_newline_ = policy.newline;
+	flush_threshold_ = policy.threshold;
+	flush_delay_ = policy.max_delay;
+}
+
+TickType_t cdc_device::process_all()
+{
+	TickType_t timeout = portMAX_DELAY;
+	for (cdc_device *device : devices)
+	{
+		if (device)
+			timeout = std::min(timeout, device->process());
+	}
+	return timeout;
+}
+
+TickType_t cdc_device::process()
+{
+	// tud_cdc_connected() must be called in the same task as tud_task, as
+	// an internal data structure is shared without locking between both
+	// functions. See https://github.com/hathach/tinyusb/issues/1472
+	// As a workaround, use an atomic variable to get the result of this
+	// function, and read from it elsewhere
+	const bool connected = tud_cdc_n_connected(interface_);
+	EventBits_t bits = 0;
+	if (connected != connected_)
+	{
+		connected_ = connected;
+		if (connected)
+			bits |= event_connected;
+		else
+			xEventGroupClearBits(events_, event_connected);
+		// Wake up readers so they notice the connection change
+		bits |= event_rx;
+	}
+
+	if (tud_cdc_n_available(interface_))
+		bits |= event_rx;
+
+	if (bits)
+	{
+		xEventGroupSetBits(events_, bits);
+		if (poll_bit_)
+			xEventGroupSetBits(poll_events(), poll_bit_);
+	}
+
+	return process_tx();
+}
+
+TickType_t cdc_device::process_tx()
+{
+	// Keep data queued until a host is around to receive it
+	if (!connected_)
+		return portMAX_DELAY;
 
-	while(!tud_cdc_available())
+	std::array<uint8_t, CFG_TUD_CDC_EP_BUFSIZE> chunk;
+	for (size_t space = tud_cdc_n_write_available(interface_); space; space = tud_cdc_n_write_available(interface_))
 	{
-		// FIXME some kind of yield?
+		size_t count = xStreamBufferReceive(
+			tx_, chunk.data(), std::min(space, chunk.size()), 0);
+		if (count == 0)
+			break;
+		// TinyUSB sends full packets on its own as they become available
+		tud_cdc_n_write(interface_, chunk.data(), count);
+		// There is room for writers again
+		if (poll_bit_)
+			xEventGroupSetBits(poll_events(), poll_bit_);
+		if (!tx_pending_)
+		{
+			tx_pending_ = true;
+			tx_pending_since_ = xTaskGetTickCount();
+		}
+	}
+
+	// A flush covers everything written before it, so it stays requested
+	// until the data queued ahead of it reached TinyUSB
+	const bool requested = xStreamBufferBytesAvailable(tx_) == 0
+		? flush_requested_.exchange(false) : flush_requested_.load();
+	if (!tx_pending_)
+		return portMAX_DELAY;
+
+	const size_t pending = CFG_TUD_CDC_TX_BUFSIZE - tud_cdc_n_write_available(interface_);
+	const TickType_t waited = xTaskGetTickCount() - tx_pending_since_;
+	if (pending == 0)
+	{
+		tx_pending_ = false;
+	}
+	else if (requested || pending >= flush_threshold_ || waited >= flush_delay_)
+	{
+		tud_cdc_n_write_flush(interface_);
+		tx_pending_ = false;
+	}
+	else
+	{
+		return flush_delay_ - waited;
+	}
+	return portMAX_DELAY;
+}
+
+int cdc_device::read(std::span<std::byte> buffer)
+{
+	return read(buffer, read_timeout_);
+}
+
+int cdc_device::read(std::span<std::byte> buffer, TickType_t timeout)
+{
+	TimeOut_t timeout_state;
+	vTaskSetTimeOutState(&timeout_state);
+	for (;;)
+	{
+		if (!connected_)
+		{
+			errno = ENXIO;
+			return -1;
+		}
+
+		// Clear the event before checking, so data arriving after the check
+		// wakes us up
+		xEventGroupClearBits(events_, event_rx);
+		if (tud_cdc_n_available(interface_))
+			break;
+
+		if (timeout == 0 || xTaskCheckForTimeOut(&timeout_state, &timeout))
+		{
+			errno = EAGAIN;
+			return -1;
+		}
+
+		xEventGroupWaitBits(events_, event_rx, pdFALSE, pdFALSE, timeout);
 	}
 
 	// There is data available
 	size_t read_;
-	for (read_ = 0; read_ < buffer.size() && tud_cdc_available();)
+	for (read_ = 0; read_ < buffer.size() && tud_cdc_n_available(interface_);)
 	{
 		// read and echo back
-		read_ += tud_cdc_read(
+		read_ += tud_cdc_n_read(interface_,
 			reinterpret_cast<unsigned char*>(buffer.data()) + read_,
 			buffer.size() - read_);
 	}
 	return static_cast<int>(read_);
 }
 
+int cdc_device::readv(std::span<const std::span<std::byte>> buffers)
+{
+	int total = 0;
+	for (auto buffer : buffers)
+	{
+		if (buffer.empty())
+			continue;
+
+		// Only wait for the first bytes, then take whatever else is there
+		int result = read(buffer, total ? 0 : read_timeout_.load());
+		if (result < 0)
+			return total ? total : result;
+		total += result;
+		if (static_cast<size_t>(result) < buffer.size())
+			break;
+	}
+	return total;
+}
+
+uint8_t cdc_device::poll_ready()
+{
+	if (!connected_)
+		return poll_hup;
+
+	uint8_t ready = 0;
+	if (tud_cdc_n_available(interface_))
+		ready |= poll_in;
+	if (xStreamBufferSpacesAvailable(tx_))
+		ready |= poll_out;
+	return ready;
+}
+
+EventBits_t cdc_device::poll_bit() const
+{
+	return poll_bit_;
+}
+
+void cdc_device::set_read_timeout(TickType_t timeout)
+{
+	read_timeout_ = timeout;
+}
+
 cdc_device cdc;
 
 }
@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/cpu_load.h>
+#include <gpico/freertos_hooks.h>
+#include <gpico/lock.h>
+#include <gpico/log.h>
+
+#include <pico/platform.h>
+#include <pico/time.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// Without run-time stats there is nothing to sample
+#if configGENERATE_RUN_TIME_STATS == 1
+
+#if configUSE_TRACE_FACILITY != 1 || INCLUDE_xTaskGetIdleTaskHandle != 1
+#error "gpico::cpu_load needs configUSE_TRACE_FACILITY and INCLUDE_xTaskGetIdleTaskHandle"
+#endif
+
+namespace gpico
+{
+	namespace
+	{
+		// Busy time accounting of a core, only updated with the scheduler
+		// locks held
+		struct core_state
+		{
+			uint32_t busy;
+			uint32_t switched_in;
+			bool idle;
+		};
+
+		// Time before the scheduler starts is not counted
+		std::array<core_state, configNUMBER_OF_CORES> cores = []{
+			std::array<core_state, configNUMBER_OF_CORES> result;
+			result.fill({0, 0, true});
+			return result;
+		}();
+
+		bool is_idle_task(TaskHandle_t task)
+		{
+			for (BaseType_t core = 0; core < configNUMBER_OF_CORES; ++core)
+			{
+				if (task == xTaskGetIdleTaskHandleForCore(core))
+					return true;
+			}
+			return false;
+		}
+
+		uint16_t permille(uint64_t part, uint64_t total)
+		{
+			if (!total)
+				return 0;
+			return std::min<uint64_t>(part * 1000 / total, 1000);
+		}
+	}
+
+	uint32_t core_busy_time(unsigned core)
+	{
+		taskENTER_CRITICAL();
+		const core_state state = cores[core];
+		const uint32_t now = time_us_32();
+		taskEXIT_CRITICAL();
+		// Include the time of the task running right now
+		return state.busy + (state.idle ? 0 : now - state.switched_in);
+	}
+
+	void cpu_load::start(TickType_t period, UBaseType_t priority, size_t log_every)
+	{
+		period_ = period;
+		log_every_ = log_every;
+		task_.create(sampler, "gpico_cpu_load", this, priority);
+	}
+
+	size_t cpu_load::clamp_window(size_t window) const
+	{
+		return std::min(window, samples_);
+	}
+
+	uint64_t cpu_load::window_sum(const std::array<uint32_t, history>& ring, size_t window) const
+	{
+		uint64_t result = 0;
+		for (size_t i = 0; i < window; ++i)
+			result += ring[(head_ + history - i) % history];
+		return result;
+	}
+
+	std::expected<uint16_t, int> cpu_load::core(unsigned core, size_t window) const
+	{
+		if (core >= configNUMBER_OF_CORES || window == 0 || window > history)
+			return std::unexpected(EINVAL);
+
+		unique_lock<mutex> lock(lock_);
+		if (!samples_)
+			return std::unexpected(EAGAIN);
+		window = clamp_window(window);
+		return permille(window_sum(busy_[core], window), window_sum(elapsed_, window));
+	}
+
+	std::expected<size_t, int> cpu_load::tasks(std::span<task_load> loads, size_t window) const
+	{
+		if (window == 0 || window > history)
+			return std::unexpected(EINVAL);
+
+		unique_lock<mutex> lock(lock_);
+		if (!samples_)
+			return std::unexpected(EAGAIN);
+		window = clamp_window(window);
+		const uint64_t elapsed = window_sum(elapsed_, window);
+		const size_t count = std::min(loads.size(), task_count_);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const tracked_task& task = tasks_[i];
+			loads[i] = {
+				task.task,
+				task.name,
+				task.affinity,
+				permille(window_sum(task.run_time, window), elapsed),
+			};
+		}
+		return count;
+	}
+
+	void cpu_load::sample(bool record)
+	{
+		const uint32_t now = time_us_32();
+		const uint32_t elapsed = now - last_time_;
+		last_time_ = now;
+
+		std::array<uint32_t, configNUMBER_OF_CORES> busy;
+		for (unsigned core = 0; core < busy.size(); ++core)
+		{
+			const uint32_t time = core_busy_time(core);
+			busy[core] = time - last_busy_[core];
+			last_busy_[core] = time;
+		}
+
+		// 0 if there are more tasks than fit in status_
+		const UBaseType_t count = uxTaskGetSystemState(
+			status_.data(), status_.size(), nullptr);
+		// Logged once each time the limit is crossed, not every period
+		if (!count && !over_limit_)
+			log<log_level::error>("cpu_load", "more than %u tasks, not sampling task loads",
+				static_cast<unsigned>(max_tasks));
+		over_limit_ = !count;
+
+		unique_lock<mutex> lock(lock_);
+		if (record)
+		{
+			head_ = (head_ + 1) % history;
+			samples_ = std::min(samples_ + 1, history);
+			elapsed_[head_] = elapsed;
+			for (unsigned core = 0; core < busy.size(); ++core)
+				busy_[core][head_] = busy[core];
+		}
+
+		for (size_t i = 0; i < task_count_; ++i)
+			tasks_[i].run_time[head_] = 0;
+		if (!count)
+			return;
+
+		// Tasks that are gone are dropped, new ones start with no history
+		std::array<bool, max_tasks> seen = {};
+		for (const TaskStatus_t& status : std::span(status_.data(), count))
+		{
+			auto end = tasks_.begin() + task_count_;
+			auto task = std::ranges::find(tasks_.begin(), end, status.xHandle, &tracked_task::task);
+			if (task == end)
+			{
+				if (task_count_ == max_tasks)
+					continue;
+				++task_count_;
+				*task = {};
+				task->task = status.xHandle;
+				task->last = status.ulRunTimeCounter;
+			}
+			seen[task - tasks_.begin()] = true;
+
+			std::strncpy(task->name.data(), status.pcTaskName, task->name.size() - 1);
+#if (configUSE_CORE_AFFINITY == 1) && (configNUMBER_OF_CORES > 1)
+			task->affinity = status.uxCoreAffinityMask;
+#else
+			task->affinity = (1u << configNUMBER_OF_CORES) - 1;
+#endif
+			task->run_time[head_] = status.ulRunTimeCounter - task->last;
+			task->last = status.ulRunTimeCounter;
+		}
+
+		size_t kept = 0;
+		for (size_t i = 0; i < task_count_; ++i)
+		{
+			if (seen[i])
+				tasks_[kept++] = tasks_[i];
+		}
+		task_count_ = kept;
+	}
+
+	void cpu_load::report(size_t window) const
+	{
+		for (unsigned core = 0; core < configNUMBER_OF_CORES; ++core)
+		{
+			auto load = this->core(core, window);
+			if (load)
+				log<log_level::info>("cpu_load", "core %u: %u.%u%%",
+					core, *load / 10, *load % 10);
+		}
+
+		std::array<task_load, max_tasks> loads;
+		auto count = tasks(loads, window);
+		if (!count)
+			return;
+		for (const task_load& load : std::span(loads.data(), *count))
+		{
+			if (load.load)
+				log<log_level::info>("cpu_load", "%s: %u.%u%%",
+					load.name.data(), load.load / 10, load.load % 10);
+		}
+	}
+
+	void cpu_load::sampler(void *param)
+	{
+		cpu_load& self = *reinterpret_cast<cpu_load*>(param);
+		const size_t log_window = std::min(self.log_every_, history);
+
+		self.sample(false);
+		TickType_t wake = xTaskGetTickCount();
+		for (size_t samples = 0;;)
+		{
+			xTaskDelayUntil(&wake, self.period_);
+			self.sample(true);
+			if (self.log_every_ && ++samples == self.log_every_)
+			{
+				samples = 0;
+				self.report(log_window);
+			}
+		}
+	}
+}
+
+extern "C" void gpico_task_switched_in(void)
+{
+	using gpico::cores;
+	const unsigned core = get_core_num();
+	auto& state = cores[core];
+	const uint32_t now = time_us_32();
+	if (!state.idle)
+		state.busy += now - state.switched_in;
+	state.switched_in = now;
+	state.idle = gpico::is_idle_task(xTaskGetCurrentTaskHandleForCore(core));
+}
+
+#endif//configGENERATE_RUN_TIME_STATS
@@ -0,0 +1,244 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/entropy.h>
+#include <gpico/lock.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <pico/rand.h>
+#include <pico/time.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace gpico
+{
+	namespace
+	{
+		constexpr size_t block_size = 64;
+
+		// Mix in fresh hardware entropy after this much output or time
+		constexpr uint64_t reseed_bytes = 1 << 20;
+		constexpr uint64_t reseed_us = 60'000'000;
+
+		using chacha_key = std::array<uint32_t, 8>;
+
+		constexpr void quarter_round(
+			std::array<uint32_t, 16>& x, int a, int b, int c, int d)
+		{
+			x[a] += x[b]; x[d] = std::rotl(x[d] ^ x[a], 16);
+			x[c] += x[d]; x[b] = std::rotl(x[b] ^ x[c], 12);
+			x[a] += x[b]; x[d] = std::rotl(x[d] ^ x[a], 8);
+			x[c] += x[d]; x[b] = std::rotl(x[b] ^ x[c], 7);
+		}
+
+		// ChaCha20 block function (RFC 8439), with an all zero nonce, as
+		// every key is only used for one request
+		void chacha20_block(
+			const chacha_key& key, uint32_t counter, std::span<std::byte, block_size> out)
+		{
+			const std::array<uint32_t, 16> input = {
+				0x6170'7865, 0x3320'646e, 0x7962'2d32, 0x6b20'6574,
+				key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+				counter, 0, 0, 0,
+			};
+
+			std::array<uint32_t, 16> x = input;
+			for (int round = 0; round < 10; ++round)
+			{
+				quarter_round(x, 0, 4, 8, 12);
+				quarter_round(x, 1, 5, 9, 13);
+				quarter_round(x, 2, 6, 10, 14);
+				quarter_round(x, 3, 7, 11, 15);
+				quarter_round(x, 0, 5, 10, 15);
+				quarter_round(x, 1, 6, 11, 12);
+				quarter_round(x, 2, 7, 8, 13);
+				quarter_round(x, 3, 4, 9, 14);
+			}
+
+			for (size_t i = 0; i < x.size(); ++i)
+				x[i] += input[i];
+			// Little-endian output, which is the native order
+			std::memcpy(out.data(), x.data(), out.size());
+			std::ranges::fill(x, 0);
+		}
+
+		class drbg
+		{
+		public:
+			drbg()
+			{
+				reseed();
+			}
+
+			void generate(std::span<std::byte> out)
+			{
+				// Small requests are served from a buffer of output, so they
+				// do not cost a ChaCha20 block each
+				size_t count = std::min(out.size(), available_);
+				take(out.first(count));
+				out = out.subspan(count);
+				if (out.empty())
+					return;
+
+				if (should_reseed())
+					reseed();
+
+				if (out.size() < buffer_.size() - key_size)
+				{
+					refill();
+					take(out);
+					return;
+				}
+
+				// Large requests are generated straight into the output.
+				// Block 0 becomes the next key, so the current key is only
+				// used once
+				const size_t size = out.size();
+				std::array<std::byte, block_size> next;
+				chacha20_block(key_, 0, next);
+				uint32_t counter = 1;
+				for (; out.size() >= block_size; out = out.subspan(block_size))
+					chacha20_block(key_, counter++, out.first<block_size>());
+				if (!out.empty())
+				{
+					std::array<std::byte, block_size> last;
+					chacha20_block(key_, counter, last);
+					std::memcpy(out.data(), last.data(), out.size());
+					std::ranges::fill(last, std::byte{0});
+				}
+				std::memcpy(key_.data(), next.data(), key_size);
+				std::ranges::fill(next, std::byte{0});
+				output_since_reseed_ += size;
+			}
+
+			void reseed()
+			{
+				// Mix fresh entropy into the key, so the new key is as good as
+				// the better of both
+				std::array<std::byte, block_size> block;
+				chacha20_block(key_, 0, block);
+				std::array<uint32_t, 8> seed;
+				for (size_t i = 0; i < seed.size(); i += 4)
+				{
+					rng_128_t random;
+					get_rand_128(&random);
+					std::memcpy(seed.data() + i, &random, sizeof(random));
+				}
+				std::memcpy(key_.data(), block.data(), key_size);
+				for (size_t i = 0; i < key_.size(); ++i)
+					key_[i] ^= seed[i];
+				std::ranges::fill(block, std::byte{0});
+				std::ranges::fill(seed, 0);
+
+				// Buffered output came from the old key
+				std::ranges::fill(buffer_, std::byte{0});
+				available_ = 0;
+				output_since_reseed_ = 0;
+				last_reseed_us_ = time_us_64();
+			}
+
+		private:
+			static constexpr size_t key_size = sizeof(chacha_key);
+
+			chacha_key key_ = {};
+			std::array<std::byte, block_size * 4> buffer_ = {};
+			size_t available_ = 0;
+			uint64_t output_since_reseed_ = 0;
+			uint64_t last_reseed_us_ = 0;
+
+			bool should_reseed() const
+			{
+				return output_since_reseed_ >= reseed_bytes ||
+					time_us_64() - last_reseed_us_ >= reseed_us;
+			}
+
+			// Generates a buffer of output with the current key, replacing
+			// the key with the start of it
+			void refill()
+			{
+				for (uint32_t i = 0; i < buffer_.size() / block_size; ++i)
+				{
+					chacha20_block(key_, i,
+						std::span(buffer_).subspan(i * block_size).first<block_size>());
+				}
+				std::memcpy(key_.data(), buffer_.data(), key_size);
+				std::fill_n(buffer_.begin(), key_size, std::byte{0});
+				available_ = buffer_.size() - key_size;
+			}
+
+			// Hands out buffered bytes, erasing them
+			void take(std::span<std::byte> out)
+			{
+				auto source = std::span(buffer_).last(available_).first(out.size());
+				std::ranges::copy(source, out.begin());
+				std::ranges::fill(source, std::byte{0});
+				available_ -= out.size();
+				output_since_reseed_ += out.size();
+			}
+		};
+
+		struct entropy_pool
+		{
+			mutex lock;
+			drbg generator;
+		};
+
+		// Created on first use, so it works during static initialization
+		entropy_pool& pool()
+		{
+			static entropy_pool instance;
+			return instance;
+		}
+
+		// Make sure the pool is created before the scheduler starts, so both
+		// cores never race to create it
+		[[maybe_unused]] entropy_pool& pool_instance = pool();
+
+		// Locking is only needed once there is more than one task
+		template<class Func>
+		void with_pool(Func&& func)
+		{
+			entropy_pool& instance = pool();
+			const bool running = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+			if (running)
+				instance.lock.lock();
+			func(instance.generator);
+			if (running)
+				instance.lock.unlock();
+		}
+	}
+
+	void get_entropy(std::span<std::byte> buffer)
+	{
+		with_pool([&](drbg& generator) { generator.generate(buffer); });
+	}
+
+	void reseed_entropy()
+	{
+		with_pool([](drbg& generator) { generator.reseed(); });
+	}
+}
+
+extern "C" int getentropy(void *buffer, size_t length) __attribute__ ((used));
+extern "C" int getentropy(void *buffer, size_t length)
+{
+	// Same limit as other implementations, callers are expected to loop
+	if (length > 256)
+	{
+		errno = EIO;
+		return -1;
+	}
+
+	gpico::get_entropy(std::span(reinterpret_cast<std::byte*>(buffer), length));
+	return 0;
+}
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/file_service.h>
+#include <gpico/crc.h>
+#include <gpico/flash.h>
+#include <gpico/rpc.h>
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
+
+#include <lfs.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <span>
+
+namespace gpico
+{
+
+file_service::file_service(rpc& transport, littlefs& fs, uint8_t base)
+:transport_(transport), fs_(fs), base_(base)
+{
+	ready_ = xQueueCreateStatic(
+		ready_buffer_.size(), sizeof(uint8_t), ready_buffer_.data(), &ready_storage_);
+	free_ = xQueueCreateStatic(
+		free_buffer_.size(), sizeof(uint8_t), free_buffer_.data(), &free_storage_);
+	for (uint8_t i = 0; i < chunks_.size(); ++i)
+		xQueueSend(free_, &i, 0);
+}
+
+bool file_service::start(UBaseType_t priority)
+{
+	bool result = transport_.register_method(base_ + method::list,
+		[this](auto request, auto response) { return list_dir(request, response); });
+	result = result && transport_.register_method(base_ + method::read,
+		[this](auto request, auto response) { return read_file(request, response); });
+	if (!result)
+		return false;
+
+	task_.create(sender, "file_service", this, priority);
+	return true;
+}
+
+const char *file_service::get_path(std::span<const std::byte> data)
+{
+	size_t size = std::min(data.size(), path_.size() - 1);
+	std::memcpy(path_.data(), data.data(), size);
+	path_[size] = '\0';
+	return path_.data();
+}
+
+std::expected<size_t, int> file_service::list_dir(
+	std::span<const std::byte> request, std::span<std::byte> response)
+{
+	uint16_t start;
+	if (request.size() < sizeof(start))
+		return std::unexpected(EINVAL);
+	std::memcpy(&start, request.data(), sizeof(start));
+
+	littlefs_dir dir = fs_.dir();
+	int result = dir.open(get_path(request.subspan(sizeof(start))));
+	if (result < 0)
+		return std::unexpected(-result);
+
+	lfs_info info;
+	size_t size = 0;
+	for (size_t index = 0; (result = dir.read(info)) > 0;)
+	{
+		if (!std::strcmp(info.name, ".") || !std::strcmp(info.name, ".."))
+			continue;
+		if (index++ < start)
+			continue;
+
+		const uint8_t type = info.type;
+		const uint32_t file_size = info.size;
+		const uint8_t length = std::strlen(info.name);
+		const size_t entry_size =
+			sizeof(type) + sizeof(file_size) + sizeof(length) + length;
+		if (size + entry_size > response.size())
+		{
+			if (size == 0)
+				return std::unexpected(EMSGSIZE);
+			break;
+		}
+
+		std::byte *entry = response.data() + size;
+		std::memcpy(entry, &type, sizeof(type));
+		std::memcpy(entry + 1, &file_size, sizeof(file_size));
+		std::memcpy(entry + 5, &length, sizeof(length));
+		std::memcpy(entry + 6, info.name, length);
+		size += entry_size;
+	}
+
+	if (result < 0)
+		return std::unexpected(-result);
+	return size;
+}
+
+std::expected<size_t, int> file_service::read_file(
+	std::span<const std::byte> request, std::span<std::byte> response)
+{
+	uint32_t offset;
+	uint32_t length;
+	if (request.size() < sizeof(offset) + sizeof(length))
+		return std::unexpected(EINVAL);
+	std::memcpy(&offset, request.data(), sizeof(offset));
+	std::memcpy(&length, request.data() + sizeof(offset), sizeof(length));
+
+	littlefs_file file = fs_.file();
+	int result = file.open(
+		get_path(request.subspan(sizeof(offset) + sizeof(length))), LFS_O_RDONLY);
+	if (result < 0)
+		return std::unexpected(-result);
+
+	lfs_soff_t size = file.size();
+	if (size < 0)
+		return std::unexpected(-size);
+	if (offset > static_cast<uint32_t>(size))
+		return std::unexpected(EINVAL);
+	if (length == 0 || length > size - offset)
+		length = size - offset;
+
+	result = file.seek(offset);
+	if (result < 0)
+		return std::unexpected(-result);
+
+	uint32_t crc = 0;
+	auto sent = stream_file(file, length, crc);
+	if (!sent)
+		return std::unexpected(sent.error());
+
+	std::memcpy(response.data(), &*sent, sizeof(*sent));
+	std::memcpy(response.data() + sizeof(*sent), &crc, sizeof(crc));
+	return sizeof(*sent) + sizeof(crc);
+}
+
+std::expected<uint32_t, int> file_service::stream_file(
+	littlefs_file& file, uint32_t length, uint32_t& crc)
+{
+	send_error_ = 0;
+	uint32_t offset = static_cast<uint32_t>(file.seek(0, LFS_SEEK_CUR));
+	uint32_t sent = 0;
+	int error = 0;
+	while (sent < length && !send_error_)
+	{
+		// Fill a free chunk while the sender transmits the other one
+		uint8_t index;
+		xQueueReceive(free_, &index, portMAX_DELAY);
+		chunk& current = chunks_[index];
+		uint32_t size = std::min<uint32_t>(length - sent, current.data.size());
+		int result = file.read(std::span(current.data).first(size));
+		if (result <= 0)
+		{
+			xQueueSend(free_, &index, 0);
+			error = result < 0 ? -result : EIO;
+			break;
+		}
+
+		current.offset = offset + sent;
+		current.size = result;
+		crc = crc32(std::span(current.data).first(result), crc);
+		sent += result;
+		xQueueSend(ready_, &index, portMAX_DELAY);
+	}
+
+	// Wait for the sender to finish with both chunks
+	std::array<uint8_t, 2> indices;
+	for (uint8_t& index : indices)
+		xQueueReceive(free_, &index, portMAX_DELAY);
+	for (uint8_t index : indices)
+		xQueueSend(free_, &index, 0);
+
+	if (send_error_)
+		return std::unexpected(send_error_.load());
+	if (error)
+		return std::unexpected(error);
+	return sent;
+}
+
+void file_service::sender(void *param)
+{
+	file_service& self = *reinterpret_cast<file_service*>(param);
+	for (;;)
+	{
+		uint8_t index;
+		xQueueReceive(self.ready_, &index, portMAX_DELAY);
+		const chunk& current = self.chunks_[index];
+		if (!self.send_error_)
+		{
+			auto result = self.transport_.stream({
+				std::as_bytes(std::span(&current.offset, 1)),
+				std::span(current.data).first(current.size)});
+			if (!result)
+				self.send_error_ = result.error();
+		}
+		xQueueSend(self.free_, &index, portMAX_DELAY);
+	}
+}
+
+}
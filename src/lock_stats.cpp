@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/lock_stats.h>
+#include <gpico/log.h>
+
+#include <hardware/sync.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+namespace gpico
+{
+#if GPICO_LOCK_STATS
+	namespace
+	{
+		// Locks are constructed from any core, before the scheduler starts
+		// and in critical sections, so the registry is guarded by a striped
+		// spin lock, which is only held to walk the list
+		spin_lock_t *registry_lock()
+		{
+			return spin_lock_instance(PICO_SPINLOCK_ID_STRIPED_LAST);
+		}
+
+		constinit lock_profile *registry = nullptr;
+	}
+
+	lock_profile::lock_profile(const void *lock, const char *name)
+	:stats{lock, name, 0, 0, 0, 0, 0, nullptr}
+	{
+		const uint32_t status = spin_lock_blocking(registry_lock());
+		next = registry;
+		if (next)
+			next->previous = this;
+		registry = this;
+		spin_unlock(registry_lock(), status);
+	}
+
+	lock_profile::~lock_profile()
+	{
+		const uint32_t status = spin_lock_blocking(registry_lock());
+		(previous ? previous->next : registry) = next;
+		if (next)
+			next->previous = previous;
+		spin_unlock(registry_lock(), status);
+	}
+
+	std::expected<size_t, int> get_lock_stats(std::span<lock_stats> stats)
+	{
+		size_t count = 0;
+		const uint32_t status = spin_lock_blocking(registry_lock());
+		const lock_profile *profile = registry;
+		for (; profile && count < stats.size(); profile = profile->next)
+			stats[count++] = profile->stats;
+		spin_unlock(registry_lock(), status);
+
+		if (profile)
+			return std::unexpected(ENOBUFS);
+		return count;
+	}
+
+	void reset_lock_stats()
+	{
+		const uint32_t status = spin_lock_blocking(registry_lock());
+		for (lock_profile *profile = registry; profile; profile = profile->next)
+		{
+			profile->stats = {profile->stats.lock, profile->stats.name,
+				0, 0, 0, 0, 0, nullptr};
+		}
+		spin_unlock(registry_lock(), status);
+	}
+#else
+	std::expected<size_t, int> get_lock_stats(std::span<lock_stats>)
+	{
+		return 0;
+	}
+
+	void reset_lock_stats()
+	{}
+#endif//GPICO_LOCK_STATS
+
+	void log_lock_stats()
+	{
+		if constexpr (!GPICO_LOCK_STATS)
+		{
+			log<log_level::info>("lock", "lock statistics not built in");
+			return;
+		}
+
+		// Locks may come and go while the list is copied, leave some room
+		std::vector<lock_stats> stats(64);
+		auto count = get_lock_stats(stats);
+		for (; !count; count = get_lock_stats(stats))
+			stats.resize(stats.size() * 2);
+		stats.resize(*count);
+
+		// Logging takes the sys_log mutex, whose statistics would change
+		// while going through them, so they are copied first
+		std::erase_if(stats, [](const lock_stats& lock) { return !lock.contended; });
+		std::ranges::sort(stats, std::ranges::greater{}, &lock_stats::total_wait_us);
+		for (const lock_stats& lock : stats)
+		{
+			char address[2 + 2 * sizeof(void*) + 1];
+			const char *name = lock.name;
+			if (!name)
+			{
+				std::snprintf(address, sizeof(address), "%p", lock.lock);
+				name = address;
+			}
+			// The last owner may have been deleted since, so it is only
+			// identified by its handle
+			log<log_level::info>("lock", "%s: %lu/%lu contended, wait %llu us "
+				"total, %lu us max, hold %lu us max, last owner %p",
+				name,
+				static_cast<unsigned long>(lock.contended),
+				static_cast<unsigned long>(lock.acquisitions),
+				static_cast<unsigned long long>(lock.total_wait_us),
+				static_cast<unsigned long>(lock.max_wait_us),
+				static_cast<unsigned long>(lock.max_hold_us),
+				static_cast<void*>(lock.last_owner));
+		}
+		if (stats.empty())
+			log<log_level::info>("lock", "no contended locks");
+	}
+}
@@ -5,7 +5,35 @@
 #include <gpico/log.h>
 #include <gpico/syslog.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+#include <string_view>
+
+// A persistent log must not be cleared on boot
+#if GPICO_SYSLOG_PERSISTENT && !defined(GPICO_SYSLOG_SECTION)
+#define GPICO_SYSLOG_SECTION ".uninitialized_data.gpico_sys_log"
+#endif
+
 namespace gpico
 {
-	safe_syslog<syslog<1024*4>> sys_log;
+#ifdef GPICO_SYSLOG_SECTION
+	__attribute__((section(GPICO_SYSLOG_SECTION)))
+#endif
+	sys_log_type sys_log;
+
+	void vlog(log_level level, const char *module, const char *format, va_list args)
+	{
+		if (!sys_log.enabled(level, module))
+			return;
+
+		std::array<char, std::min<size_t>(GPICO_LOG_MAX_LENGTH, sys_log_type::max_length()) + 1> message;
+		const int length = vsnprintf(message.data(), message.size(), format, args);
+		if (length < 0)
+			return;
+
+		sys_log.push(level, module,
+			std::string_view(message.data(), std::min<size_t>(length, message.size() - 1)));
+	}
 }
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Locking for the C library, so stdio, malloc, and the rest of the library
+// can be used from tasks on both cores at the same time.
+//
+// newlib (and picolibc) call the retargetable locking functions below around
+// every access to shared state, e.g. a FILE while printf formats into it, so
+// a printf call is never interleaved with another one on the same stream.
+//
+// With newlib, it also gives each task its own errno.
+
+#include <gpico/lock.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <sys/lock.h>
+#ifndef __PICOLIBC__
+#include <reent.h>
+#include <sys/reent.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+// FreeRTOS implements newlib reentrancy by pointing newlib's _impure_ptr, a
+// single global, at the reentrancy structure of the task switched in. With
+// more than one core, the core switching tasks last wins, and tasks on the
+// other core use the wrong structure
+#if configUSE_NEWLIB_REENTRANT && configNUMBER_OF_CORES > 1
+#error "configUSE_NEWLIB_REENTRANT is not safe with more than one core"
+#endif
+
+// Thread local storage pointer holding the errno of each task, -1 to keep a
+// single errno shared by all tasks
+#ifndef GPICO_ERRNO_TLS_INDEX
+#define GPICO_ERRNO_TLS_INDEX 0
+#endif
+
+// Locks are constant initialized, as the C library may use them before static
+// constructors run, and the mutex behind each is created on first use once
+// the scheduler is running
+struct __lock
+{
+	std::atomic<gpico::recursive_mutex*> mutex;
+	alignas(gpico::recursive_mutex) std::byte storage[sizeof(gpico::recursive_mutex)];
+};
+
+// Static locks used by the C library
+#ifdef __PICOLIBC__
+struct __lock __lock___libc_recursive_mutex;
+#else
+struct __lock __lock___sinit_recursive_mutex;
+struct __lock __lock___sfp_recursive_mutex;
+struct __lock __lock___atexit_recursive_mutex;
+struct __lock __lock___at_quick_exit_mutex;
+struct __lock __lock___malloc_recursive_mutex;
+struct __lock __lock___env_recursive_mutex;
+struct __lock __lock___tz_mutex;
+struct __lock __lock___dd_hash_mutex;
+struct __lock __lock___arc4random_mutex;
+#endif
+
+// Returns the mutex behind the lock, or nullptr if locking is not needed or
+// not possible: before the scheduler starts there is only one thread of
+// execution, and interrupt handlers and tasks with the scheduler suspended
+// cannot block
+static gpico::recursive_mutex *get_mutex(_LOCK_T lock)
+{
+	if (!lock || portCHECK_IF_IN_ISR() ||
+			xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+		return nullptr;
+
+	gpico::recursive_mutex *mutex = lock->mutex.load(std::memory_order_acquire);
+	if (!mutex)
+	{
+		taskENTER_CRITICAL();
+		mutex = lock->mutex.load(std::memory_order_relaxed);
+		if (!mutex)
+		{
+			mutex = new (lock->storage) gpico::recursive_mutex;
+			lock->mutex.store(mutex, std::memory_order_release);
+		}
+		taskEXIT_CRITICAL();
+	}
+	return mutex;
+}
+
+extern "C" void __retarget_lock_init(_LOCK_T *lock)
+{
+	*lock = new (std::nothrow) __lock{};
+}
+
+extern "C" void __retarget_lock_init_recursive(_LOCK_T *lock)
+{
+	__retarget_lock_init(lock);
+}
+
+extern "C" void __retarget_lock_close(_LOCK_T lock)
+{
+	if (auto mutex = lock ? lock->mutex.load() : nullptr)
+		mutex->~recursive_mutex();
+	delete lock;
+}
+
+extern "C" void __retarget_lock_close_recursive(_LOCK_T lock)
+{
+	__retarget_lock_close(lock);
+}
+
+extern "C" void __retarget_lock_acquire(_LOCK_T lock)
+{
+	if (auto mutex = get_mutex(lock))
+		mutex->lock();
+}
+
+extern "C" void __retarget_lock_acquire_recursive(_LOCK_T lock)
+{
+	__retarget_lock_acquire(lock);
+}
+
+extern "C" int __retarget_lock_try_acquire(_LOCK_T lock)
+{
+	auto mutex = get_mutex(lock);
+	return mutex ? mutex->try_lock() : 1;
+}
+
+extern "C" int __retarget_lock_try_acquire_recursive(_LOCK_T lock)
+{
+	return __retarget_lock_try_acquire(lock);
+}
+
+extern "C" void __retarget_lock_release(_LOCK_T lock)
+{
+	if (auto mutex = get_mutex(lock))
+		mutex->unlock();
+}
+
+extern "C" void __retarget_lock_release_recursive(_LOCK_T lock)
+{
+	__retarget_lock_release(lock);
+}
+
+#ifndef __PICOLIBC__
+struct _reent;
+
+extern "C" void __malloc_lock(struct _reent *)
+{
+	__retarget_lock_acquire_recursive(&__lock___malloc_recursive_mutex);
+}
+
+extern "C" void __malloc_unlock(struct _reent *)
+{
+	__retarget_lock_release_recursive(&__lock___malloc_recursive_mutex);
+}
+#endif
+
+// Per-task errno. newlib's errno macro goes through __errno(), which returns
+// the errno of the one global reentrancy structure, so a task on one core
+// could overwrite it between another task's failing call and its read of
+// errno. picolibc already keeps errno in thread local storage.
+#if !defined(__PICOLIBC__) && GPICO_ERRNO_TLS_INDEX >= 0
+
+#if GPICO_ERRNO_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS
+#error "Per-task errno needs configNUM_THREAD_LOCAL_STORAGE_POINTERS above GPICO_ERRNO_TLS_INDEX, or GPICO_ERRNO_TLS_INDEX set to -1"
+#endif
+
+// Before newlib 4.3
+#ifndef _REENT_ERRNO
+#define _REENT_ERRNO(ptr) ((ptr)->_errno)
+#endif
+
+extern "C" int _read(int fd, char *buf, int count);
+extern "C" int _write(int fd, char *buf, int count);
+extern "C" int _open(const char *name, int flags, int mode);
+extern "C" int _close(int fd);
+
+// The errno of the running task is kept in the thread local storage pointer
+// itself, so nothing is allocated for it. The API only hands out the value of
+// the pointer, so it is reached through StaticTask_t, which mirrors the layout
+// of the task control block
+static int *task_errno()
+{
+	static_assert(sizeof(void*) >= sizeof(int));
+	auto *task = reinterpret_cast<StaticTask_t*>(xTaskGetCurrentTaskHandle());
+	return reinterpret_cast<int*>(&task->pvDummy15[GPICO_ERRNO_TLS_INDEX]);
+}
+
+// Interrupt handlers, and everything before the scheduler starts, use the
+// global errno
+extern "C" int *__errno(void)
+{
+	int *shared = &_REENT_ERRNO(_REENT);
+	if (portCHECK_IF_IN_ISR() || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+		return shared;
+
+	// Some library functions set errno in the reentrancy structure directly,
+	// e.g. strtol() setting ERANGE, so that is moved to the task reading
+	// errno. Only for these can another task still pick it up first
+	int *own = task_errno();
+	if (*shared)
+	{
+		taskENTER_CRITICAL();
+		if (*shared)
+		{
+			*own = *shared;
+			*shared = 0;
+		}
+		taskEXIT_CRITICAL();
+	}
+	return own;
+}
+
+// The library's wrappers of the system calls copy errno into the reentrancy
+// structure on failure, where __errno() would hand it to whichever task reads
+// errno next. These replace the ones of the calls gpico implements, leaving
+// errno in the calling task's alone
+extern "C" _ssize_t _read_r(struct _reent *, int fd, void *buf, size_t count)
+{
+	return _read(fd, static_cast<char*>(buf), static_cast<int>(count));
+}
+
+extern "C" _ssize_t _write_r(struct _reent *, int fd, const void *buf, size_t count)
+{
+	return _write(fd, static_cast<char*>(const_cast<void*>(buf)), static_cast<int>(count));
+}
+
+extern "C" int _open_r(struct _reent *, const char *name, int flags, int mode)
+{
+	return _open(name, flags, mode);
+}
+
+extern "C" int _close_r(struct _reent *, int fd)
+{
+	return _close(fd);
+}
+
+#endif
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/poll.h>
+#include <gpico/io_device.h>
+
+#include <FreeRTOS.h>
+#include <event_groups.h>
+#include <task.h>
+
+#include <span>
+
+namespace gpico
+{
+	// The top byte of event groups is reserved by FreeRTOS
+	static constexpr unsigned poll_bit_count = sizeof(EventBits_t) * 8 - 8;
+
+	static StaticEventGroup_t events_buffer;
+	static EventGroupHandle_t events = xEventGroupCreateStatic(&events_buffer);
+	// Constant initialized, as files allocate bits from their constructors
+	static unsigned next_bit = 0;
+
+	EventGroupHandle_t poll_events()
+	{
+		return events;
+	}
+
+	EventBits_t allocate_poll_bit()
+	{
+		EventBits_t bit = 0;
+		taskENTER_CRITICAL();
+		if (next_bit < poll_bit_count)
+			bit = EventBits_t{1} << next_bit++;
+		taskEXIT_CRITICAL();
+		return bit;
+	}
+
+	int poll(std::span<poll_fd> fds, TickType_t timeout)
+	{
+		EventBits_t bits = 0;
+		for (const poll_fd& fd : fds)
+			bits |= fd.file->poll_bit();
+
+		TimeOut_t timeout_state;
+		vTaskSetTimeOutState(&timeout_state);
+		for (;;)
+		{
+			// Clear the bits before checking, so changes after the check wake
+			// us up
+			if (bits)
+				xEventGroupClearBits(events, bits);
+
+			int count = 0;
+			for (poll_fd& fd : fds)
+			{
+				fd.revents = fd.file->poll_ready() & (fd.events | poll_hup);
+				if (fd.revents)
+					++count;
+			}
+
+			if (count || timeout == 0 || xTaskCheckForTimeOut(&timeout_state, &timeout))
+				return count;
+
+			if (bits)
+				xEventGroupWaitBits(events, bits, pdFALSE, pdFALSE, timeout);
+			else
+				vTaskDelay(timeout);
+		}
+	}
+}
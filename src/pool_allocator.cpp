@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/pool_allocator.h>
+
+#include <hardware/sync.h>
+#include <pico/platform.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <new>
+
+// The pools take RAM, so they only exist when asked for
+#if GPICO_POOL_ALLOCATOR
+
+namespace gpico
+{
+	namespace
+	{
+		constexpr size_t pool_classes = pool_blocks.size();
+		constexpr size_t smallest_block = 16;
+		constexpr size_t largest_block = smallest_block << (pool_classes - 1);
+
+		constexpr std::array<size_t, pool_classes> class_offsets = []{
+			std::array<size_t, pool_classes> result = {};
+			size_t offset = 0;
+			for (size_t i = 0; i < pool_classes; ++i)
+			{
+				result[i] = offset;
+				offset += pool_blocks[i] * (smallest_block << i);
+			}
+			return result;
+		}();
+
+		constexpr size_t arena_size = class_offsets.back() +
+			pool_blocks.back() * largest_block;
+
+		// Free blocks hold the pointer to the next free block
+		struct free_block
+		{
+			free_block *next;
+		};
+
+		// All zero, so it needs no initialization and can be used before
+		// static constructors run. Blocks never used are taken in order, then
+		// freed ones are reused through the free list.
+		struct pool_class
+		{
+			free_block *free_list;
+			size_t unused;
+			size_t in_use;
+			size_t high_water;
+			uint32_t allocations;
+			uint32_t failures;
+		};
+
+		alignas(8) constinit std::array<std::byte, arena_size> arena = {};
+		constinit std::array<pool_class, pool_classes> classes = {};
+		constinit uint32_t fallback_allocations = 0;
+		constinit uint32_t fallback_failures = 0;
+
+		// Striped spin locks are shared with the pico-sdk, but only for short
+		// critical sections that don't nest, which these are. Each class has
+		// its own, so classes don't contend.
+		spin_lock_t *class_lock(size_t index)
+		{
+			return spin_lock_instance(PICO_SPINLOCK_ID_STRIPED_FIRST +
+				index % (PICO_SPINLOCK_ID_STRIPED_LAST - PICO_SPINLOCK_ID_STRIPED_FIRST + 1));
+		}
+
+		// The fallback counters are updated from both cores, so they get the
+		// next striped lock
+		spin_lock_t *fallback_lock()
+		{
+			return class_lock(pool_classes);
+		}
+
+		std::byte *class_begin(size_t index)
+		{
+			return arena.data() + class_offsets[index];
+		}
+
+		size_t class_of(size_t size)
+		{
+			size_t index = 0;
+			while ((smallest_block << index) < size)
+				++index;
+			return index;
+		}
+
+		void *class_allocate(size_t index)
+		{
+			pool_class& pool = classes[index];
+			const uint32_t status = spin_lock_blocking(class_lock(index));
+			void *result = nullptr;
+			if (pool.free_list)
+			{
+				result = pool.free_list;
+				pool.free_list = pool.free_list->next;
+			}
+			else if (pool.unused < pool_blocks[index])
+			{
+				result = class_begin(index) + pool.unused++ * (smallest_block << index);
+			}
+
+			if (result)
+			{
+				++pool.allocations;
+				pool.high_water = std::max(pool.high_water, ++pool.in_use);
+			}
+			spin_unlock(class_lock(index), status);
+			return result;
+		}
+	}
+
+	void *pool_allocate(size_t size)
+	{
+		if (size <= largest_block)
+		{
+			// Spill over to larger classes before giving up on the pools
+			const size_t first = class_of(std::max<size_t>(size, 1));
+			for (size_t index = first; index < pool_classes; ++index)
+			{
+				if (void *result = class_allocate(index))
+					return result;
+				if (index == first)
+				{
+					const uint32_t status = spin_lock_blocking(class_lock(index));
+					++classes[index].failures;
+					spin_unlock(class_lock(index), status);
+				}
+			}
+		}
+
+		void *result = std::malloc(size);
+		const uint32_t status = spin_lock_blocking(fallback_lock());
+		++(result ? fallback_allocations : fallback_failures);
+		spin_unlock(fallback_lock(), status);
+		return result;
+	}
+
+	void pool_free(void *ptr)
+	{
+		const uintptr_t block = reinterpret_cast<uintptr_t>(ptr);
+		const uintptr_t begin = reinterpret_cast<uintptr_t>(arena.data());
+		if (block < begin || block >= begin + arena.size())
+		{
+			std::free(ptr);
+			return;
+		}
+
+		size_t index = pool_classes - 1;
+		while (block < begin + class_offsets[index])
+			--index;
+
+		pool_class& pool = classes[index];
+		const uint32_t status = spin_lock_blocking(class_lock(index));
+		free_block *freed = new (ptr) free_block{pool.free_list};
+		pool.free_list = freed;
+		--pool.in_use;
+		spin_unlock(class_lock(index), status);
+	}
+
+	pool_stats get_pool_stats()
+	{
+		pool_stats result = {};
+		for (size_t index = 0; index < pool_classes; ++index)
+		{
+			const uint32_t status = spin_lock_blocking(class_lock(index));
+			const pool_class pool = classes[index];
+			spin_unlock(class_lock(index), status);
+
+			result.classes[index] = {
+				smallest_block << index,
+				pool_blocks[index],
+				pool.in_use,
+				pool.high_water,
+				pool.allocations,
+				pool.failures,
+			};
+		}
+		const uint32_t status = spin_lock_blocking(fallback_lock());
+		result.fallback_allocations = fallback_allocations;
+		result.fallback_failures = fallback_failures;
+		spin_unlock(fallback_lock(), status);
+		return result;
+	}
+}
+
+// These replace the pico-sdk ones, disabled with
+// PICO_CXX_DISABLE_ALLOCATION_OVERRIDES. The nothrow variants are replaced
+// too, as libstdc++ implements them by calling operator new, which panics on
+// failure without exceptions, and callers such as the newlib lock hooks
+// expect them to return null.
+
+void *operator new(std::size_t size)
+{
+	void *result = gpico::pool_allocate(size);
+	if (!result)
+	{
+#if __cpp_exceptions
+		throw std::bad_alloc();
+#else
+		panic("out of memory");
+#endif
+	}
+	return result;
+}
+
+void *operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return gpico::pool_allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return gpico::pool_allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	gpico::pool_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	gpico::pool_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	gpico::pool_free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+	gpico::pool_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) noexcept
+{
+	gpico::pool_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept
+{
+	gpico::pool_free(ptr);
+}
+
+#endif//GPICO_POOL_ALLOCATOR
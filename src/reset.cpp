@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Gabriel Marcano, 2024
 /// @file
 
+#include <gpico/static_task.h>
 #include <gpico/watchdog.h>
 
 #include <hardware/structs/mpu.h>
@@ -17,6 +18,10 @@
 
 namespace gpico
 {
+	// Shared by both kinds of reset, only the first one requested runs. Its
+	// memory is reserved so a reset can't fail when the heap is exhausted.
+	static static_task<configMINIMAL_STACK_SIZE> reset_task_storage;
+
 	[[noreturn]] static void reset_task(void* kind)
 	{
 		bool bootsel = static_cast<bool>(kind);
@@ -33,6 +38,9 @@ namespace gpico
 		}
 		else
 		{
+			// This reset is intentional, so do not report it on the next
+			// boot
+			clear_watchdog_record();
 			watchdog_enable(0, true);
 		}
         taskEXIT_CRITICAL();
@@ -43,27 +51,23 @@ namespace gpico
 
 	[[noreturn]] void bootsel_reset()
 	{
-		xTaskCreateAffinitySet(
+		reset_task_storage.create(
 			reset_task,
 			"gpico_reset",
-			configMINIMAL_STACK_SIZE,
 			reinterpret_cast<void*>(true),
 			tskIDLE_PRIORITY+3,
-			(1 << 0),
-			nullptr);
+			(1 << 0));
 		for(;;);
 	}
 
 	[[noreturn]] void flash_reset()
 	{
-		xTaskCreateAffinitySet(
+		reset_task_storage.create(
 			reset_task,
 			"gpico_reset",
-			configMINIMAL_STACK_SIZE,
 			reinterpret_cast<void*>(false),
 			tskIDLE_PRIORITY+3,
-			(1 << 0),
-			nullptr);
+			(1 << 0));
         for(;;);
 	}
 }
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/rpc.h>
+#include <gpico/cobs.h>
+#include <gpico/crc.h>
+#include <gpico/lock.h>
+
+#include <FreeRTOS.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <span>
+
+// Frames are sent and parsed in the device's native byte order
+static_assert(std::endian::native == std::endian::little);
+static_assert(sizeof(gpico::rpc::header) == 4);
+
+namespace gpico
+{
+
+rpc::rpc(cdc_device& device)
+:device_(device), decoder_({rx_buffer_.data(), rx_buffer_.size()})
+{}
+
+bool rpc::register_method(uint8_t id, handler func)
+{
+	if (id >= method::reserved || method_count_ == methods_.size())
+		return false;
+
+	auto methods = std::span(methods_).first(method_count_);
+	if (std::ranges::find(methods, id, &std::pair<uint8_t, handler>::first) != methods.end())
+		return false;
+
+	methods_[method_count_++] = {id, std::move(func)};
+	return true;
+}
+
+void rpc::serve()
+{
+	// Frames are flushed as a whole, so newlines in binary data should not
+	// cause partial packets to be sent
+	cdc_flush_policy policy;
+	policy.newline = false;
+	device_.set_flush_policy(policy);
+
+	std::array<std::byte, 64> chunk;
+	for (;;)
+	{
+		if (!device_.connected())
+		{
+			// A new host session starts from scratch
+			subscriptions_ = 0;
+			decoder_.reset();
+			device_.probe();
+		}
+
+		int count = device_.read(chunk, portMAX_DELAY);
+		if (count <= 0)
+			continue;
+
+		for (std::byte byte : std::span(chunk).first(count))
+		{
+			if (decoder_.put(byte) == cobs::decoder::status::complete)
+				dispatch(decoder_.frame());
+		}
+	}
+}
+
+bool rpc::subscribed(uint8_t topic) const
+{
+	return topic < 32 && (subscriptions_ & (1u << topic));
+}
+
+std::expected<void, int> rpc::publish(
+	uint8_t topic, std::span<const std::span<const std::byte>> parts)
+{
+	if (!subscribed(topic))
+		return {};
+	if (parts.size() > max_parts)
+		return std::unexpected(EINVAL);
+	return send({kind::publish, topic, 0}, parts);
+}
+
+std::expected<void, int> rpc::stream(
+	std::span<const std::span<const std::byte>> parts)
+{
+	if (parts.size() > max_parts)
+		return std::unexpected(EINVAL);
+	return send({kind::stream, request_.id, request_.tag}, parts);
+}
+
+std::expected<void, int> rpc::send(
+	header head, std::span<const std::span<const std::byte>> parts, bool block)
+{
+	std::unique_lock<mutex> lock(send_lock_, std::defer_lock);
+	if (block)
+		lock.lock();
+	else if (!lock.try_lock())
+		return std::unexpected(EAGAIN);
+
+	uint32_t crc = crc32(head);
+	size_t size = sizeof(head) + sizeof(crc);
+	for (auto part : parts)
+	{
+		crc = crc32(part, crc);
+		size += part.size();
+	}
+
+	// COBS adds at most a code byte per 254 bytes, plus one, and then there
+	// is the delimiter. Nothing else writes to the device, so the room only
+	// grows until the frame is written
+	if (!block && device_.write_available() < size + size / 254 + 2)
+		return std::unexpected(EAGAIN);
+
+	std::array<std::span<const std::byte>, max_parts + 2> frame;
+	frame[0] = std::as_bytes(std::span(&head, 1));
+	std::ranges::copy(parts, frame.begin() + 1);
+	frame[parts.size() + 1] = std::as_bytes(std::span(&crc, 1));
+
+	// Code bytes and short runs are gathered to avoid many tiny writes, while
+	// long runs go straight from the caller's buffers to the device
+	std::array<std::byte, 64> staging;
+	size_t staged = 0;
+	bool failed = false;
+	auto write = [&](std::span<const std::byte> data)
+	{
+		if (!failed && device_.write(data) != static_cast<int>(data.size()))
+			failed = true;
+	};
+	auto put = [&](std::span<const std::byte> data)
+	{
+		if (staged + data.size() > staging.size())
+		{
+			write(std::span(staging).first(staged));
+			staged = 0;
+		}
+
+		if (data.size() >= staging.size())
+		{
+			write(data);
+		}
+		else
+		{
+			std::ranges::copy(data, staging.begin() + staged);
+			staged += data.size();
+		}
+	};
+
+	cobs::encode(std::span(frame).first(parts.size() + 2), put);
+	const std::byte delimiter{0};
+	put(std::span(&delimiter, 1));
+	write(std::span(staging).first(staged));
+	device_.flush();
+
+	if (failed)
+		return std::unexpected(ENXIO);
+	return {};
+}
+
+void rpc::dispatch(std::span<const std::byte> frame)
+{
+	if (frame.size() < sizeof(header) + sizeof(uint32_t))
+		return;
+
+	auto contents = frame.first(frame.size() - sizeof(uint32_t));
+	uint32_t crc;
+	std::memcpy(&crc, contents.data() + contents.size(), sizeof(crc));
+	if (crc32(contents) != crc)
+		return;
+
+	header head;
+	std::memcpy(&head, contents.data(), sizeof(head));
+	if (head.type != kind::request)
+		return;
+	request_ = head;
+
+	auto result = call(head.id, contents.subspan(sizeof(header)));
+	if (result)
+	{
+		send({kind::response, head.id, head.tag},
+			{{std::span<const std::byte>(response_buffer_).first(*result)}});
+	}
+	else
+	{
+		const int32_t error = result.error();
+		send({kind::error, head.id, head.tag},
+			{{std::as_bytes(std::span(&error, 1))}});
+	}
+}
+
+std::expected<size_t, int> rpc::call(
+	uint8_t id, std::span<const std::byte> request)
+{
+	switch (id)
+	{
+	case method::ping:
+		std::ranges::copy(request, response_buffer_.begin());
+		return request.size();
+	case method::subscribe:
+	case method::unsubscribe:
+	{
+		if (request.size() != 1 || static_cast<uint8_t>(request[0]) >= 32)
+			return std::unexpected(EINVAL);
+		const uint32_t bit = 1u << static_cast<uint8_t>(request[0]);
+		if (id == method::subscribe)
+			subscriptions_ |= bit;
+		else
+			subscriptions_ &= ~bit;
+		return 0;
+	}
+	default:
+		break;
+	}
+
+	auto methods = std::span(methods_).first(method_count_);
+	auto method = std::ranges::find(methods, id, &std::pair<uint8_t, handler>::first);
+	if (method == methods.end())
+		return std::unexpected(ENOSYS);
+
+	auto result = method->second(request, response_buffer_);
+	if (result && *result > response_buffer_.size())
+		return std::unexpected(EMSGSIZE);
+	return result;
+}
+
+}
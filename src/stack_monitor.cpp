@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/stack_monitor.h>
+#include <gpico/lock.h>
+#include <gpico/log.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// Without the trace facility there are no high water marks of all tasks
+#if configUSE_TRACE_FACILITY == 1
+
+namespace gpico
+{
+	std::expected<size_t, int> stack_high_water_marks(
+		std::span<TaskStatus_t> status, std::span<task_stack> stacks)
+	{
+		status = status.first(std::min(status.size(), stacks.size()));
+		// 0 if there are more tasks than fit
+		const UBaseType_t count = uxTaskGetSystemState(
+			status.data(), status.size(), nullptr);
+		if (!count)
+			return std::unexpected(ENOBUFS);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			stacks[i] = {status[i].xHandle, {}, status[i].usStackHighWaterMark};
+			std::strncpy(stacks[i].name.data(), status[i].pcTaskName,
+				stacks[i].name.size() - 1);
+		}
+		return count;
+	}
+
+	// Buffers of log_stack_high_water_marks(), too large for the stack of
+	// most tasks
+	static mutex log_stacks_lock;
+	static std::array<TaskStatus_t, stack_monitor::max_tasks> log_status;
+	static std::array<task_stack, stack_monitor::max_tasks> log_stacks;
+
+	void log_stack_high_water_marks()
+	{
+		unique_lock lock(log_stacks_lock);
+		auto count = stack_high_water_marks(log_status, log_stacks);
+		if (!count)
+		{
+			log<log_level::error>("stack", "more than %u tasks, not logging stacks",
+				static_cast<unsigned>(stack_monitor::max_tasks));
+			return;
+		}
+
+		for (const task_stack& stack : std::span(log_stacks.data(), *count))
+			log<log_level::info>("stack", "%s: %lu words free",
+				stack.name.data(), static_cast<unsigned long>(stack.free_words));
+	}
+
+	void stack_monitor::start(TickType_t period, UBaseType_t priority, uint32_t margin_words)
+	{
+		period_ = period;
+		margin_words_ = margin_words;
+		task_.create(monitor, "gpico_stack", this, priority);
+	}
+
+	void stack_monitor::check()
+	{
+		auto count = stack_high_water_marks(status_, stacks_);
+		if (!count)
+		{
+			log<log_level::error>("stack", "more than %u tasks, not checking stacks",
+				static_cast<unsigned>(max_tasks));
+			return;
+		}
+
+		std::array<low_mark, max_tasks> warned;
+		size_t warned_count = 0;
+		for (const task_stack& stack : std::span(stacks_.data(), *count))
+		{
+			auto end = warned_.begin() + warned_count_;
+			auto previous = std::ranges::find(warned_.begin(), end, stack.task, &low_mark::task);
+			uint32_t lowest = previous != end ? previous->free_words : margin_words_;
+			if (stack.free_words < lowest)
+			{
+				log<log_level::warning>("stack", "%s: only %lu words free",
+					stack.name.data(), static_cast<unsigned long>(stack.free_words));
+				lowest = stack.free_words;
+			}
+			if (lowest < margin_words_)
+				warned[warned_count++] = {stack.task, lowest};
+		}
+		warned_ = warned;
+		warned_count_ = warned_count;
+	}
+
+	void stack_monitor::monitor(void *param)
+	{
+		stack_monitor& self = *reinterpret_cast<stack_monitor*>(param);
+		for(;;)
+		{
+			self.check();
+			vTaskDelay(self.period_);
+		}
+	}
+}
+
+#endif//configUSE_TRACE_FACILITY
@@ -3,30 +3,23 @@
 /// @file
 
 #include <gpico/cdc_device.h>
+#include <gpico/syscalls.h>
 
 #include <tusb.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <span>
 #include <cstdint>
 #include <atomic>
 #include <array>
 #include <cstdio>
-#include <tuple>
 #include <memory>
 #include <optional>
+#include <cstring>
 
-#include <errno.h>
-#undef errno
-extern int errno;
-
-#include <pico/rand.h>
-
-static gpico::file_descriptor* files[10] = {
-	&gpico::cdc_descriptor,
-	&gpico::cdc_descriptor,
-	&gpico::cdc_descriptor,
-};
+#include <FreeRTOS.h>
+#include <task.h>
 
 // Just hang if we call a pure virtual function, the default implementation
 // relies on too much stuff
@@ -50,95 +43,318 @@ namespace __gnu_cxx
 	}
 }
 
-// Allow registration of up to N devices
-static std::optional<std::tuple<const char*, gpico::io_device&>> devices[10];
+namespace
+{
+	/** Table of open files, indexed by file descriptor number.
+	 *
+	 * Free slots are chained in a list, so allocating one takes constant
+	 * time. Every IO call holds a reference to the slot it uses, so closing
+	 * a file that is in use only detaches it, and the last reference frees
+	 * the slot. The table is shared by both cores, so it is protected by a
+	 * critical section, and no file calls are made while it is held.
+	 */
+	class file_table
+	{
+	public:
+		// Constant initialized, so stdio works before static constructors
+		// run
+		constexpr file_table()
+		{
+			for (int fd = 0; fd < 3; ++fd)
+				slots_[fd] = {&gpico::cdc_descriptor, 1, true, -1};
+			for (int fd = 3; fd < static_cast<int>(slots_.size()); ++fd)
+			{
+				const bool last = fd + 1 == static_cast<int>(slots_.size());
+				slots_[fd] = {nullptr, 0, false, static_cast<int16_t>(last ? -1 : fd + 1)};
+			}
+			free_ = slots_.size() > 3 ? 3 : -1;
+		}
+
+		/** Assigns a file descriptor number to the given file.
+		 *
+		 * @returns The file descriptor number, or -1 if there is no room.
+		 */
+		int install(gpico::file_descriptor *file)
+		{
+			taskENTER_CRITICAL();
+			int fd = free_;
+			if (fd >= 0)
+			{
+				free_ = slots_[fd].next;
+				slots_[fd] = {file, 1, true, -1};
+			}
+			taskEXIT_CRITICAL();
+			return fd;
+		}
+
+		/** Takes a reference to the file with the given descriptor number.
+		 *
+		 * @returns The file, or nullptr if the descriptor is not open.
+		 */
+		gpico::file_descriptor *acquire(int fd)
+		{
+			if (fd < 0 || fd >= static_cast<int>(slots_.size()))
+				return nullptr;
+
+			taskENTER_CRITICAL();
+			slot& entry = slots_[fd];
+			gpico::file_descriptor *file = nullptr;
+			if (entry.open)
+			{
+				++entry.references;
+				file = entry.file;
+			}
+			taskEXIT_CRITICAL();
+			return file;
+		}
+
+		/** Drops a reference taken by acquire.
+		 */
+		void release(int fd)
+		{
+			taskENTER_CRITICAL();
+			gpico::file_descriptor *file = drop(fd);
+			taskEXIT_CRITICAL();
+			if (file)
+				file->close();
+		}
+
+		/** Closes the given descriptor number.
+		 *
+		 * @returns 0 on success, or -1 if the descriptor is not open. If
+		 *  this was the last reference to the file, the result of closing
+		 *  the file.
+		 */
+		int close(int fd)
+		{
+			if (fd < 0 || fd >= static_cast<int>(slots_.size()))
+				return -1;
+
+			taskENTER_CRITICAL();
+			slot& entry = slots_[fd];
+			bool open = entry.open;
+			gpico::file_descriptor *file = nullptr;
+			if (open)
+			{
+				entry.open = false;
+				file = drop(fd);
+			}
+			taskEXIT_CRITICAL();
+
+			if (!open)
+				return -1;
+			return file ? file->close() : 0;
+		}
+
+	private:
+		struct slot
+		{
+			gpico::file_descriptor *file;
+			uint16_t references;
+			bool open;
+			int16_t next;
+		};
+
+		std::array<slot, GPICO_MAX_FILES> slots_ = {};
+		int free_ = -1;
+
+		// Must be called in the critical section. Returns the file to close,
+		// if the last reference to it was dropped
+		gpico::file_descriptor *drop(int fd)
+		{
+			slot& entry = slots_[fd];
+			if (--entry.references)
+				return nullptr;
+
+			gpico::file_descriptor *file = entry.file;
+			entry = {nullptr, 0, false, static_cast<int16_t>(free_)};
+			free_ = fd;
+
+			// The same file may be behind other descriptor numbers (e.g.
+			// stdio)
+			for (const slot& other : slots_)
+			{
+				if (other.file == file)
+					return nullptr;
+			}
+			return file;
+		}
+	};
+
+	constinit file_table files;
+
+	// Holds a reference to an open file for the duration of an IO call
+	class file_reference
+	{
+	public:
+		explicit file_reference(int fd)
+		:fd_(fd), file_(files.acquire(fd))
+		{}
 
-void register_device(size_t index, std::tuple<const char*, gpico::io_device&> device)
+		~file_reference()
+		{
+			if (file_)
+				files.release(fd_);
+		}
+
+		file_reference(const file_reference&) = delete;
+		file_reference& operator=(const file_reference&) = delete;
+
+		gpico::file_descriptor *operator->() const
+		{
+			return file_;
+		}
+
+		explicit operator bool() const
+		{
+			return file_;
+		}
+
+	private:
+		int fd_;
+		gpico::file_descriptor *file_;
+	};
+
+	struct device_entry
+	{
+		const char *prefix;
+		size_t length;
+		gpico::io_device *device;
+	};
+
+	constinit std::array<device_entry, GPICO_MAX_DEVICES> devices = {};
+}
+
+static_assert(GPICO_MAX_FILES > 3 && GPICO_MAX_FILES <= INT16_MAX);
+
+namespace gpico
 {
-	devices[index] = device;
+	bool register_device(const char *prefix, io_device& device)
+	{
+		const size_t length = std::strlen(prefix);
+		bool result = false;
+		taskENTER_CRITICAL();
+		auto same = [&](const device_entry& entry) {
+			return entry.device && entry.length == length &&
+				std::strncmp(entry.prefix, prefix, length) == 0;
+		};
+		if (std::ranges::none_of(devices, same))
+		{
+			auto entry = std::ranges::find(devices, nullptr, &device_entry::device);
+			if (entry != devices.end())
+			{
+				*entry = {prefix, length, &device};
+				result = true;
+			}
+		}
+		taskEXIT_CRITICAL();
+		return result;
+	}
+
+	bool unregister_device(const char *prefix)
+	{
+		const size_t length = std::strlen(prefix);
+		bool result = false;
+		taskENTER_CRITICAL();
+		for (device_entry& entry : devices)
+		{
+			if (entry.device && entry.length == length &&
+				std::strncmp(entry.prefix, prefix, length) == 0)
+			{
+				entry = {};
+				result = true;
+				break;
+			}
+		}
+		taskEXIT_CRITICAL();
+		return result;
+	}
 }
 
-void unregister_device(size_t index)
+// Finds the device with the longest prefix matching the path, as a whole
+// path component
+static std::optional<device_entry> find_device(const char *path)
 {
-	devices[index].reset();
+	std::optional<device_entry> result;
+	taskENTER_CRITICAL();
+	for (const device_entry& entry : devices)
+	{
+		if (!entry.device || (result && result->length >= entry.length))
+			continue;
+		if (std::strncmp(entry.prefix, path, entry.length) != 0)
+			continue;
+		const char next = path[entry.length];
+		if (next == '\0' || next == '/' || (entry.length && entry.prefix[entry.length - 1] == '/'))
+			result = entry;
+	}
+	taskEXIT_CRITICAL();
+	return result;
 }
 
+// These set errno through the C library's errno macro, which gives the
+// calling task's own errno (see newlib_support.cpp)
+
 // Apparently, if I don't declare this function as used, LTO gets rid of it...
 extern "C" int _write(int fd, char *buf, int count) __attribute__ ((used));
 extern "C" int _write(int fd, char *buf, int count)
 {
-	if (!files[fd])
+	file_reference file(fd);
+	if (!file)
 	{
 		errno = EBADF;
 		return -1;
 	}
 
-	gpico::file_descriptor& desc = *files[fd];
-	return desc.write(std::span<const std::byte>(reinterpret_cast<std::byte*>(buf), count));
+	return file->write(std::span<const std::byte>(reinterpret_cast<std::byte*>(buf), count));
 }
 
 extern "C" int _read(int fd, char *buf, int count) __attribute__ ((used));
 extern "C" int _read(int fd, char *buf, int count)
 {
-	if (!files[fd])
+	file_reference file(fd);
+	if (!file)
 	{
-		errno = ENOENT;
+		errno = EBADF;
 		return -1;
 	}
-	gpico::file_descriptor& desc = *files[fd];
-	return desc.read(std::span<std::byte>(reinterpret_cast<std::byte*>(buf), count));
+
+	return file->read(std::span<std::byte>(reinterpret_cast<std::byte*>(buf), count));
 }
 
 extern "C" int _open(const char *name, int flags, int mode) __attribute__ ((used));
 extern "C" int _open(const char *name, int /*flags*/, int /*mode*/)
 {
-	std::expected<gpico::file_descriptor*, int> desc;
-	for (size_t i = 0; i < 10 && !desc; ++i)
+	auto entry = find_device(name);
+	if (!entry)
 	{
-		if (devices[i] && (strcmp(std::get<const char*>(*devices[i]), name) == 0))
-		{
-			auto& device = std::get<1>(*devices[i]);
-			desc = device.open(name);
-		}
+		errno = ENOENT;
+		return -1;
 	}
 
-	if (desc)
+	auto desc = entry->device->open(name + entry->length);
+	if (!desc)
 	{
-		for (size_t i = 3; i < 10; ++i)
-		{
-			if (!files[i])
-			{
-				files[i] = *desc;
-				return i;
-			}
-		}
+		errno = desc.error();
+		return -1;
 	}
-	errno = ENOENT;
-	return -1;
-}
 
-extern "C" int _close(int fd) __attribute__ ((used));
-extern "C" int _close(int fd)
-{
-	if (files[fd])
+	int fd = files.install(*desc);
+	if (fd < 0)
 	{
-		files[fd] = nullptr;
-		return 0;
+		(*desc)->close();
+		errno = EMFILE;
+		return -1;
 	}
-	errno = EBADF;
-	return -1;
+	return fd;
 }
 
-extern "C" int getentropy(void *buffer, size_t length) __attribute__ ((used));
-extern "C" int getentropy(void *buffer, size_t length)
+extern "C" int _close(int fd) __attribute__ ((used));
+extern "C" int _close(int fd)
 {
-	uint32_t random = get_rand_32();
-	size_t i;
-	for (i = 0; i < length - 3; i += 4)
+	if (files.close(fd) < 0)
 	{
-		memcpy(reinterpret_cast<unsigned char*>(buffer)+i, &random, 4);
-		random = get_rand_32();
+		errno = EBADF;
+		return -1;
 	}
-	memcpy(reinterpret_cast<unsigned char*>(buffer) + i - 4, &random, length % 4);
 	return 0;
 }
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include <gpico/trace.h>
+#include <gpico/freertos_hooks.h>
+#include <gpico/rpc.h>
+
+#include <hardware/structs/timer.h>
+#include <hardware/sync.h>
+#include <pico/platform.h>
+#include <pico/time.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#if GPICO_TRACE && configUSE_TRACE_FACILITY != 1
+#error "GPICO_TRACE needs configUSE_TRACE_FACILITY"
+#endif
+
+namespace gpico
+{
+	namespace
+	{
+		struct trace_event
+		{
+			uint32_t time;
+			uint32_t data;
+		};
+
+		// Each core only writes to its own ring, with interrupts disabled, so
+		// no locking is needed between writers
+		struct trace_ring
+		{
+			uint32_t head;
+			std::array<trace_event, trace_events> events;
+		};
+
+		// No storage is used unless tracing is built in
+		std::array<trace_ring, GPICO_TRACE ? configNUMBER_OF_CORES : 0> rings;
+		std::atomic<bool> enabled = GPICO_TRACE;
+
+		enum record : uint8_t
+		{
+			header_record = 0,
+			task_record = 1,
+			events_record = 2,
+		};
+
+		std::expected<size_t, int> dump(rpc& transport,
+			std::span<const std::byte> request, std::span<std::byte> response)
+		{
+			const bool clear = !request.empty() &&
+				(std::to_integer<uint8_t>(request[0]) & 1);
+
+			// Pause recording. Writers that already checked the flag finish
+			// within a few cycles, well before the header is sent.
+			const bool was_enabled = enabled.exchange(false);
+
+			uint32_t sent = 0;
+			auto result = [&]() -> std::expected<void, int> {
+				const std::array<uint8_t, 8> header = {
+					header_record,
+					configNUMBER_OF_CORES,
+					trace_events & 0xFF, trace_events >> 8,
+					// The timer counts microseconds
+					0x40, 0x42, 0x0F, 0x00,
+				};
+				auto result = transport.stream({std::as_bytes(std::span(header))});
+				if (!result)
+					return result;
+
+#if configUSE_TRACE_FACILITY == 1
+				std::vector<TaskStatus_t> tasks(uxTaskGetNumberOfTasks());
+				tasks.resize(uxTaskGetSystemState(tasks.data(), tasks.size(), nullptr));
+				for (const TaskStatus_t& task : tasks)
+				{
+					const uint32_t handle = reinterpret_cast<uintptr_t>(task.xHandle) & 0xFF'FFFF;
+					std::array<uint8_t, 8> info = {task_record};
+					std::memcpy(info.data() + 4, &handle, sizeof(handle));
+					result = transport.stream({
+						std::as_bytes(std::span(info)),
+						std::as_bytes(std::span(task.pcTaskName, std::strlen(task.pcTaskName))),
+					});
+					if (!result)
+						return result;
+				}
+#endif
+
+				for (uint8_t core = 0; core < rings.size(); ++core)
+				{
+					const trace_ring& ring = rings[core];
+					const uint32_t head = ring.head;
+					const uint32_t count = std::min<uint32_t>(head, trace_events);
+					const uint32_t lost = head - count;
+					std::array<uint8_t, 8> info = {events_record, core};
+					std::memcpy(info.data() + 4, &lost, sizeof(lost));
+
+					// The oldest events may be at the end of the ring
+					const size_t start = (head - count) % trace_events;
+					const size_t first = std::min<size_t>(count, trace_events - start);
+					result = transport.stream({
+						std::as_bytes(std::span(info)),
+						std::as_bytes(std::span(ring.events).subspan(start, first)),
+						std::as_bytes(std::span(ring.events).first(count - first)),
+					});
+					if (!result)
+						return result;
+					sent += count;
+				}
+				return {};
+			}();
+
+			if (clear)
+			{
+				for (trace_ring& ring : rings)
+					ring.head = 0;
+			}
+			enabled = was_enabled;
+
+			if (!result)
+				return std::unexpected(result.error());
+			std::memcpy(response.data(), &sent, sizeof(sent));
+			return sizeof(sent);
+		}
+	}
+
+	void trace_enable(bool enable)
+	{
+		enabled = enable && GPICO_TRACE;
+	}
+
+	bool register_trace_method(rpc& transport, uint8_t id)
+	{
+		return transport.register_method(id,
+			[&transport](auto request, auto response) {
+				return dump(transport, request, response);
+			});
+	}
+}
+
+extern "C" void __time_critical_func(gpico_trace_event)(uint32_t type, const void *object)
+{
+	using gpico::rings;
+	if (!gpico::enabled.load(std::memory_order_relaxed))
+		return;
+
+	const uint32_t status = save_and_disable_interrupts();
+	auto& ring = rings[get_core_num()];
+	const uint32_t head = ring.head;
+	ring.events[head % gpico::trace_events] = {
+		timer_hw->timerawl,
+		(type << 24) | static_cast<uint32_t>(reinterpret_cast<uintptr_t>(object) & 0xFF'FFFF),
+	};
+	ring.head = head + 1;
+	restore_interrupts(status);
+}
@@ -4,6 +4,7 @@
 
 #include <tusb_config.h>
 #include <tusb.h>
+#include <device/usbd_pvt.h>
 #include <bsp/board_api.h>
 
 #include <FreeRTOS.h>
@@ -12,49 +13,83 @@
 
 #include <gpico/usb.h>
 #include <gpico/cdc_device.h>
+#include <gpico/static_task.h>
 
 #include <atomic>
+#include <cstdint>
 
-static std::atomic_bool cdc_connected = false;
+static std::atomic_bool wake_pending = false;
+// The TinyUSB event queue only exists after tusb_init
+static std::atomic_bool usb_started = false;
+static gpico::static_task<configMINIMAL_STACK_SIZE> usb_task;
 
 namespace gpico
 {
 
 bool usb_cdc_connected()
 {
-	return cdc_connected;
+	return cdc.connected();
+}
+
+// Runs in the USB task, all the work happens after tud_task returns
+static void usb_task_woken(void*)
+{
+	wake_pending = false;
+}
+
+void usb_task_wake()
+{
+#if CFG_TUSB_OS == OPT_OS_FREERTOS
+	// Before the USB task starts there is nothing to wake, and it processes
+	// everything pending once it does. Only one wake up at a time, so
+	// writers never block on a full TinyUSB event queue
+	if (usb_started && !wake_pending.exchange(true))
+		usbd_defer_func(usb_task_woken, nullptr, false);
+#endif
+}
+
+// Rounds up, so short timeouts never become a busy poll with tick rates
+// above 1 kHz
+[[maybe_unused]] static uint32_t ticks_to_ms(TickType_t ticks)
+{
+	return (static_cast<uint64_t>(ticks) * 1000 + configTICK_RATE_HZ - 1) /
+		configTICK_RATE_HZ;
 }
 
 // FreeRTOS task to handle USB tasks
 static void usb_device_task(void*)
 {
 	tusb_init();
+	usb_started = true;
 	for(;;)
 	{
+		// Processing first picks up anything queued before usb_started was
+		// set, whose wake up was skipped
+		const TickType_t timeout = cdc_device::process_all();
+#if CFG_TUSB_OS == OPT_OS_FREERTOS
+		// Block on the TinyUSB event queue until the USB interrupt, or a task
+		// through usb_task_wake, posts an event, or until pending CDC data is
+		// due to be flushed
+		tud_task_ext(timeout == portMAX_DELAY ? UINT32_MAX : ticks_to_ms(timeout),
+			false);
+#else
+		// Without an RTOS aware TinyUSB there is nothing to block on, so poll
 		tud_task();
-		// FIXME does the pico-sdk tinyusb functionality not honor FreeRTOS
-		// blocking?
 		vTaskDelay(1);
-		// tud_cdc_connected() must be called in the same task as tud_task, as
-		// an internal data structure is shared without locking between both
-		// functions. See https://github.com/hathach/tinyusb/issues/1472
-		// As a workaround, use an atomic variable to get the result of this
-		// function, and read from it elsewhere
-		cdc_connected = tud_cdc_connected();
+		(void)timeout;
+#endif
 	}
 }
 
 void initialize_usb_task()
 {
 	// Only install this in CPU 1
-	xTaskCreateAffinitySet(
+	usb_task.create(
 		usb_device_task,
 		"gpico_usb",
-		configMINIMAL_STACK_SIZE,
 		nullptr,
 		tskIDLE_PRIORITY+2,
-		(1 << 1),
-		nullptr);
+		(1 << 1));
 }
 
 }
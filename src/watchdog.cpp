@@ -3,8 +3,14 @@
 /// @file
 
 #include <gpico/watchdog.h>
+#include <gpico/lock.h>
+#include <gpico/log.h>
+#include <gpico/static_task.h>
 
+#include <hardware/structs/watchdog.h>
 #include <hardware/watchdog.h>
+#include <pico/platform.h>
+#include <pico/time.h>
 
 #include <FreeRTOS.h>
 #include <queue.h>
@@ -13,25 +19,351 @@
 #include <atomic>
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <vector>
 
 namespace gpico
 {
 	constexpr const int cpu_cores = 2;
-	static std::array<std::atomic_bool, cpu_cores> watchdog_cpu_status;
 	static std::array<const char*, cpu_cores> watchdog_task_names {
 		"gpico_watchdog_cpu0",
 		"gpico_watchdog_cpu1"
 	};
 
-	void watchdog_cpu_task(void* status)
+	// Stack sizes in words, from the worst case call chains reported by
+	// -fstack-usage plus the context switch frame, with about half to spare.
+	// Check them with log_stack_high_water_marks() after changing the tasks
+	static std::array<static_task<64>, cpu_cores> watchdog_cpu_tasks;
+	static static_task<96> watchdog_core_task;
+
+	// Last task other than the watchdog tasks switched out on each core, set
+	// by the context switch hook of gpico/freertos_hooks.h. It may have been
+	// deleted since, which is harmless, as only its address and the first
+	// byte of its name are read
+	static std::array<std::atomic<TaskHandle_t>, cpu_cores> switched_out = {};
+
+	static bool is_watchdog_task(TaskHandle_t task)
+	{
+		return task == watchdog_core_task.handle() ||
+			std::ranges::any_of(watchdog_cpu_tasks,
+				[task](const auto& cpu_task) { return cpu_task.handle() == task; });
+	}
+
+	// Names of the heartbeats of the per-core tasks, short enough to fit in
+	// the watchdog record
+	static std::array<const char*, cpu_cores> watchdog_heartbeat_names {
+		"cpu0",
+		"cpu1"
+	};
+
+	// Heartbeats of the per-core tasks, kept out of their small stacks
+	static std::array<std::optional<heartbeat>, cpu_cores> watchdog_cpu_heartbeats;
+
+	// Period of the per-core tasks, and how late they may be
+	constexpr const uint32_t watchdog_cpu_period_ms = 150;
+	constexpr const uint32_t watchdog_cpu_deadline_ms = 300;
+
+	static mutex registry_lock;
+	static std::array<heartbeat*, GPICO_MAX_HEARTBEATS> heartbeats = {};
+
+	heartbeat::heartbeat(const char *name, uint32_t period_us, uint32_t deadline_us)
+	:name_(name), period_us_(period_us), deadline_us_(deadline_us),
+		last_beat_us_(time_us_32())
+	{
+		unique_lock<mutex> lock(registry_lock);
+		auto slot = std::ranges::find(heartbeats, nullptr);
+		registered_ = slot != heartbeats.end();
+		if (registered_)
+			*slot = this;
+	}
+
+	heartbeat::~heartbeat()
+	{
+		if (registered_)
+		{
+			unique_lock<mutex> lock(registry_lock);
+			*std::ranges::find(heartbeats, this) = nullptr;
+		}
+	}
+
+	void heartbeat::beat()
+	{
+		const uint32_t now = time_us_32();
+		const uint32_t interval = now - last_beat_us_;
+		const uint32_t jitter = interval > period_us_ ? interval - period_us_ : 0;
+
+		taskENTER_CRITICAL();
+		++beats_;
+		max_jitter_us_ = std::max(max_jitter_us_, jitter);
+		++jitter_histogram_[std::bit_width(jitter)];
+		taskEXIT_CRITICAL();
+
+		last_beat_us_ = now;
+	}
+
+	bool heartbeat::registered() const
+	{
+		return registered_;
+	}
+
+	const char *heartbeat::name() const
+	{
+		return name_;
+	}
+
+	heartbeat_stats heartbeat::stats() const
+	{
+		taskENTER_CRITICAL();
+		heartbeat_stats result = {beats_, max_jitter_us_, 0, missed_deadlines_};
+		const auto histogram = jitter_histogram_;
+		taskEXIT_CRITICAL();
+
+		// Find the bucket holding the 99th percentile, and report its upper
+		// bound
+		const uint32_t rank = result.beats - result.beats / 100;
+		uint32_t count = 0;
+		for (size_t bucket = 0; bucket < histogram.size() && rank; ++bucket)
+		{
+			count += histogram[bucket];
+			if (count >= rank)
+			{
+				if (bucket == 0)
+					result.p99_jitter_us = 0;
+				else if (bucket < 32)
+					result.p99_jitter_us = uint32_t{1} << bucket;
+				else
+					result.p99_jitter_us = std::numeric_limits<uint32_t>::max();
+				break;
+			}
+		}
+		return result;
+	}
+
+	bool heartbeat::expired() const
 	{
+		// Read the last beat first, so it is never newer than now
+		const uint32_t last = last_beat_us_;
+		return time_us_32() - last > deadline_us_;
+	}
+
+	void heartbeat::reset_stats()
+	{
+		taskENTER_CRITICAL();
+		beats_ = 0;
+		max_jitter_us_ = 0;
+		missed_deadlines_ = 0;
+		jitter_histogram_ = {};
+		taskEXIT_CRITICAL();
+	}
+
+	void for_each_heartbeat(const std::function<void(const heartbeat_info&)>& func)
+	{
+		// Hold the registry lock only to copy, as the watchdog task needs it
+		std::array<heartbeat_info, GPICO_MAX_HEARTBEATS> infos;
+		size_t count = 0;
+		{
+			unique_lock<mutex> lock(registry_lock);
+			for (const heartbeat *beat : heartbeats)
+			{
+				if (beat)
+					infos[count++] = {beat->name(), beat->stats()};
+			}
+		}
+
+		for (const heartbeat_info& info : std::span(infos).first(count))
+			func(info);
+	}
+
+	// Returns the first heartbeat not meeting its deadline, if any
+	const heartbeat *watchdog_check_heartbeats()
+	{
+		const heartbeat *result = nullptr;
+		unique_lock<mutex> lock(registry_lock);
+		for (heartbeat *beat : heartbeats)
+		{
+			if (!beat)
+				continue;
+
+			const bool expired = beat->expired();
+			if (expired && !beat->late_)
+			{
+				taskENTER_CRITICAL();
+				++beat->missed_deadlines_;
+				taskEXIT_CRITICAL();
+			}
+			beat->late_ = expired;
+			if (expired && !result)
+				result = beat;
+		}
+		return result;
+	}
+
+	// Watchdog record, in the scratch registers not used by the pico-sdk:
+	//  0: magic in the top byte, uptime in seconds in the rest
+	//  1: first 4 characters of the name of the heartbeat that missed its
+	//     deadline, 0 if none
+	//  2, 3: task running on cores 0 and 1, or the one a watchdog task
+	//     preempted there: the low 24 bits of its handle (as in trace dumps),
+	//     and the first character of its name in the top byte, 0 if none
+	// Or, after a stack overflow:
+	//  0: overflow magic in the top byte, uptime in seconds in the rest
+	//  1-3: first 12 characters of the name of the task that overflowed
+	constexpr const uint32_t watchdog_record_magic = 0x67;
+	constexpr const uint32_t stack_overflow_magic = 0x73;
+
+	static uint32_t pack_name(const char *name)
+	{
+		char packed[4] = {};
+		if (name)
+			std::strncpy(packed, name, sizeof(packed));
+		uint32_t result;
+		std::memcpy(&result, packed, sizeof(result));
+		return result;
+	}
+
+	// The watchdog tasks run briefly and at a high priority, so the task they
+	// preempted is the one that may be hogging the core
+	static TaskHandle_t running_task(int core)
+	{
+		TaskHandle_t task = xTaskGetCurrentTaskHandleForCore(core);
+		if (task && is_watchdog_task(task))
+		{
+			TaskHandle_t preempted = switched_out[core].load(std::memory_order_relaxed);
+			if (preempted)
+				task = preempted;
+		}
+		return task;
+	}
+
+	static uint32_t pack_task(TaskHandle_t task)
+	{
+		if (!task)
+			return 0;
+		const uint32_t handle = reinterpret_cast<uintptr_t>(task) & 0xFF'FFFF;
+		return (static_cast<uint32_t>(static_cast<uint8_t>(pcTaskGetName(task)[0])) << 24) | handle;
+	}
+
+	// Describes a task packed by pack_task(), by the name of the task with the
+	// same handle now, if there is one, as statically allocated tasks keep
+	// their handles across resets
+	static void describe_task(uint32_t packed, std::span<char> out)
+	{
+		const uint32_t handle = packed & 0xFF'FFFF;
+		const char initial = static_cast<char>(packed >> 24);
+		const char *name = nullptr;
+#if configUSE_TRACE_FACILITY == 1
+		std::vector<TaskStatus_t> tasks(uxTaskGetNumberOfTasks());
+		tasks.resize(uxTaskGetSystemState(tasks.data(), tasks.size(), nullptr));
+		for (const TaskStatus_t& task : tasks)
+		{
+			if ((reinterpret_cast<uintptr_t>(task.xHandle) & 0xFF'FFFF) == handle &&
+					task.pcTaskName[0] == initial)
+				name = task.pcTaskName;
+		}
+#endif
+		if (!packed)
+			std::snprintf(out.data(), out.size(), "unknown");
+		else if (name)
+			std::snprintf(out.data(), out.size(), "%s (0x%06lx)",
+				name, static_cast<unsigned long>(handle));
+		else
+			std::snprintf(out.data(), out.size(), "%c... (0x%06lx)",
+				initial, static_cast<unsigned long>(handle));
+	}
+
+	static void write_watchdog_record(const heartbeat *missing)
+	{
+		// Keep the record of a stack overflow until the reset it leads to
+		if ((watchdog_hw->scratch[0] >> 24) == stack_overflow_magic)
+			return;
+
+		const uint32_t uptime = time_us_64() / 1'000'000;
+		watchdog_hw->scratch[0] = (watchdog_record_magic << 24) | (uptime & 0xFF'FFFF);
+		watchdog_hw->scratch[1] = pack_name(missing ? missing->name() : nullptr);
+		for (int core = 0; core < cpu_cores; ++core)
+			watchdog_hw->scratch[2 + core] = pack_task(running_task(core));
+	}
+
+	// Watchdog scratch registers 0 to 3, as left by the last boot
+	using watchdog_record = std::array<uint32_t, 4>;
+
+	// Returns the record left before a watchdog reset, clearing it, or an
+	// empty record if the reset was not caused by the watchdog
+	static watchdog_record take_watchdog_record()
+	{
+		watchdog_record result = {};
+		if (watchdog_enable_caused_reboot())
+		{
+			for (size_t i = 0; i < result.size(); ++i)
+				result[i] = watchdog_hw->scratch[i];
+		}
+		clear_watchdog_record();
+		return result;
+	}
+
+	static void report_watchdog_record(const watchdog_record& record)
+	{
+		const uint32_t header = record[0];
+		if ((header >> 24) == watchdog_record_magic)
+		{
+			char missing[5] = {};
+			std::memcpy(missing, &record[1], sizeof(record[1]));
+			std::array<char[configMAX_TASK_NAME_LEN + 16], cpu_cores> running;
+			for (int core = 0; core < cpu_cores; ++core)
+				describe_task(record[2 + core], running[core]);
+			log<log_level::critical>("watchdog",
+				"watchdog reset after %lu s, missed heartbeat: %s, running: %s (core 0), %s (core 1)",
+				static_cast<unsigned long>(header & 0xFF'FFFF),
+				missing[0] ? missing : "none", running[0], running[1]);
+		}
+		else if ((header >> 24) == stack_overflow_magic)
+		{
+			char name[13] = {};
+			std::memcpy(name, &record[1], 3 * sizeof(record[1]));
+			log<log_level::critical>("watchdog",
+				"watchdog reset after %lu s, stack overflow in task %s",
+				static_cast<unsigned long>(header & 0xFF'FFFF), name);
+		}
+	}
+
+	void record_stack_overflow(const char *task_name)
+	{
+		const uint32_t uptime = time_us_64() / 1'000'000;
+		char name[12] = {};
+		if (task_name)
+			std::strncpy(name, task_name, sizeof(name));
+		for (size_t i = 0; i < 3; ++i)
+		{
+			uint32_t packed;
+			std::memcpy(&packed, name + i * sizeof(packed), sizeof(packed));
+			watchdog_hw->scratch[1 + i] = packed;
+		}
+		watchdog_hw->scratch[0] = (stack_overflow_magic << 24) | (uptime & 0xFF'FFFF);
+	}
+
+	void clear_watchdog_record()
+	{
+		for (int i = 0; i < 4; ++i)
+			watchdog_hw->scratch[i] = 0;
+	}
+
+	static void watchdog_cpu_task(void* core)
+	{
+		const size_t index = reinterpret_cast<uintptr_t>(core);
+		heartbeat& beat = watchdog_cpu_heartbeats[index].emplace(
+			watchdog_heartbeat_names[index],
+			watchdog_cpu_period_ms * 1000,
+			watchdog_cpu_deadline_ms * 1000);
 		for(;;)
 		{
-			std::atomic_bool &status_ =
-				*reinterpret_cast<std::atomic_bool*>(status);
-			status_ = true;
-			vTaskDelay(150);
+			beat.beat();
+			vTaskDelay(pdMS_TO_TICKS(watchdog_cpu_period_ms));
 		}
 	}
 
@@ -43,43 +375,50 @@ namespace gpico
 		watchdog_enable(400, true);
 		for(;;)
 		{
-			// The compiler is apparently smart enough to optimize this by
-			// unrolling the range check
-			constexpr const auto value = [](bool val){return val;};
-			if (std::ranges::all_of(watchdog_cpu_status, value))
-			{
+			// Stop feeding the watchdog as soon as any task is late, so the
+			// system resets
+			const heartbeat *missing = watchdog_check_heartbeats();
+			write_watchdog_record(missing);
+			if (!missing)
 				watchdog_update();
-				std::ranges::fill(watchdog_cpu_status, 0);
-			}
-			vTaskDelay(170);
+			vTaskDelay(pdMS_TO_TICKS(50));
 		}
 	}
 
 	void initialize_watchdog_tasks()
 	{
+		// Taken before the watchdog task overwrites it, but reported after
+		// creating the tasks, so their names are known
+		const watchdog_record record = take_watchdog_record();
+
 		// Watchdog priority is higher
 		// Dedicated watchdog tasks on each core, and have a central watchdog task
-		// aggregate the watchdog flags from both other tasks.
+		// check the heartbeats of both other tasks, and of any other task that
+		// registered one.
 		// If one core locks up, the central task will detect it and not pet the
 		// watchdog, or it will itself be hung, leading to a system reset.
 		for (size_t i = 0; i < cpu_cores; ++i)
 		{
-			xTaskCreateAffinitySet(
+			watchdog_cpu_tasks[i].create(
 				watchdog_cpu_task,
 				watchdog_task_names[i],
-				64,
-				&watchdog_cpu_status[i],
+				reinterpret_cast<void*>(i),
 				tskIDLE_PRIORITY+5,
-				1 << i,
-				nullptr);
+				1 << i);
 		}
-		xTaskCreateAffinitySet(
+		watchdog_core_task.create(
 			watchdog_task,
 			"gpico_watchdog_core",
-			64,
 			nullptr,
 			tskIDLE_PRIORITY+5,
-			(1 << 0) | (1 << 1),
-			nullptr);
+			(1 << 0) | (1 << 1));
+		report_watchdog_record(record);
 	}
 }
+
+extern "C" void __time_critical_func(gpico_task_switched_out)(void *task)
+{
+	TaskHandle_t handle = static_cast<TaskHandle_t>(task);
+	if (!gpico::is_watchdog_task(handle))
+		gpico::switched_out[get_core_num()].store(handle, std::memory_order_relaxed);
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// gpico::channel, with a producer and a consumer thread standing in for
+// tasks on both cores.
+
+#include "test.h"
+
+#include <gpico/channel.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace gpico
+{
+	struct channel_test_access
+	{
+		template<class Channel>
+		static void start_at(Channel& channel, uint32_t index)
+		{
+			channel.head_ = index;
+			channel.tail_ = index;
+		}
+	};
+}
+
+namespace
+{
+	using namespace std::chrono_literals;
+
+	constexpr uint32_t count = 100'000;
+
+	// Messages are numbered, and carry their number twice so a torn message
+	// is noticed
+	struct message
+	{
+		uint32_t number;
+		uint32_t check;
+	};
+
+	using test_channel = gpico::channel<message, 8>;
+
+	void test_nonblocking()
+	{
+		test_channel channel;
+		GPICO_CHECK(channel.empty());
+		GPICO_CHECK(!channel.peek(0));
+		GPICO_CHECK(channel.receive(0).error() == EAGAIN);
+
+		for (uint32_t i = 0; i < test_channel::capacity; ++i)
+			GPICO_CHECK(channel.send({i, ~i}, 0));
+		GPICO_CHECK(channel.size() == test_channel::capacity);
+		GPICO_CHECK(!channel.prepare(0));
+		GPICO_CHECK(!channel.send({}, 0));
+
+		// prepare() and peek() return the same slot until it is used
+		message *first = channel.peek(0);
+		GPICO_CHECK(first && first == channel.peek(0));
+		for (uint32_t i = 0; i < test_channel::capacity; ++i)
+		{
+			auto result = channel.receive(0);
+			if (GPICO_CHECK(result))
+				GPICO_CHECK(result->number == i && result->check == ~i);
+		}
+		GPICO_CHECK(channel.empty());
+		GPICO_CHECK(channel.receive(0).error() == EAGAIN);
+
+		message *slot = channel.prepare(0);
+		GPICO_CHECK(slot && slot == channel.prepare(0));
+	}
+
+	// A timeout waits about that long, and EAGAIN is returned after it
+	void test_timeout()
+	{
+		test_channel channel;
+		const auto start = std::chrono::steady_clock::now();
+		GPICO_CHECK(channel.receive(pdMS_TO_TICKS(20)).error() == EAGAIN);
+		GPICO_CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+
+		for (uint32_t i = 0; i < test_channel::capacity; ++i)
+			channel.send({i, ~i}, 0);
+		GPICO_CHECK(!channel.send({}, pdMS_TO_TICKS(20)));
+		GPICO_CHECK(!channel.prepare(pdMS_TO_TICKS(1)));
+	}
+
+	// Checks every message arrives in order, with the indices starting just
+	// short of wrapping around, so they wrap early on
+	template<class Produce, class Consume>
+	void run(uint32_t start, Produce produce, Consume consume)
+	{
+		test_channel channel;
+		gpico::channel_test_access::start_at(channel, start);
+
+		std::thread producer([&] {
+			for (uint32_t i = 0; i < count; ++i)
+				produce(channel, message{i, ~i});
+		});
+		uint32_t errors = 0;
+		std::thread consumer([&] {
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const message m = consume(channel);
+				if (m.number != i || m.check != ~i)
+					++errors;
+				if (channel.size() > test_channel::capacity)
+					++errors;
+			}
+		});
+		producer.join();
+		consumer.join();
+		GPICO_CHECK(errors == 0);
+		GPICO_CHECK(channel.empty());
+	}
+
+	void test_slots(uint32_t start)
+	{
+		run(start,
+			[](test_channel& channel, message m) {
+				message *slot = channel.prepare();
+				*slot = m;
+				channel.commit();
+			},
+			[](test_channel& channel) {
+				const message *slot = channel.peek();
+				const message result = *slot;
+				channel.release();
+				return result;
+			});
+	}
+
+	void test_messages(uint32_t start)
+	{
+		run(start,
+			[](test_channel& channel, message m) {
+				channel.send(m);
+			},
+			[](test_channel& channel) {
+				return channel.receive().value_or(message{});
+			});
+	}
+
+	// Polling both sides with no timeout, as interrupt handlers would
+	void test_polling(uint32_t start)
+	{
+		run(start,
+			[](test_channel& channel, message m) {
+				while (!channel.send(m, 0))
+					std::this_thread::yield();
+			},
+			[](test_channel& channel) {
+				for (;;)
+				{
+					if (auto result = channel.receive(0))
+						return *result;
+					std::this_thread::yield();
+				}
+			});
+	}
+}
+
+int main()
+{
+	test_nonblocking();
+	test_timeout();
+	for (uint32_t start : {0u, UINT32_MAX - 3})
+	{
+		test_slots(start);
+		test_messages(start);
+		test_polling(start);
+	}
+	gpico::test::finish();
+}
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// COBS framing and CRC-32, both header-only.
+
+#include "test.h"
+
+#include <gpico/cobs.h>
+#include <gpico/crc.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	using bytes = std::vector<std::byte>;
+
+	bytes make(std::initializer_list<int> values)
+	{
+		bytes result;
+		for (int value : values)
+			result.push_back(std::byte(value));
+		return result;
+	}
+
+	bytes range(int first, int last)
+	{
+		bytes result;
+		for (int value = first; value <= last; ++value)
+			result.push_back(std::byte(value));
+		return result;
+	}
+
+	bytes concat(std::initializer_list<bytes> parts)
+	{
+		bytes result;
+		for (const bytes& part : parts)
+			result.insert(result.end(), part.begin(), part.end());
+		return result;
+	}
+
+	bytes encode(std::span<const std::span<const std::byte>> parts)
+	{
+		bytes result;
+		gpico::cobs::encode(parts, [&](std::span<const std::byte> data) {
+			result.insert(result.end(), data.begin(), data.end());
+		});
+		return result;
+	}
+
+	// Decodes a stream of bytes, returning the last frame completed
+	bytes decode(const bytes& stream, size_t capacity, gpico::cobs::decoder::status& last)
+	{
+		bytes buffer(capacity);
+		gpico::cobs::decoder decoder(buffer);
+		bytes result;
+		last = gpico::cobs::decoder::status::incomplete;
+		for (std::byte byte : stream)
+		{
+			auto status = decoder.put(byte);
+			if (status == gpico::cobs::decoder::status::complete)
+				result.assign(decoder.frame().begin(), decoder.frame().end());
+			if (status != gpico::cobs::decoder::status::incomplete)
+				last = status;
+		}
+		return result;
+	}
+
+	struct vector
+	{
+		bytes decoded;
+		bytes encoded;
+	};
+
+	// Examples from the COBS paper and Wikipedia, covering 254 and 255 byte
+	// runs
+	const std::vector<vector> vectors = {
+		{{}, make({0x01})},
+		{make({0x00}), make({0x01, 0x01})},
+		{make({0x00, 0x00}), make({0x01, 0x01, 0x01})},
+		{make({0x00, 0x11, 0x00}), make({0x01, 0x02, 0x11, 0x01})},
+		{make({0x11, 0x22, 0x00, 0x33}), make({0x03, 0x11, 0x22, 0x02, 0x33})},
+		{make({0x11, 0x22, 0x33, 0x44}), make({0x05, 0x11, 0x22, 0x33, 0x44})},
+		{make({0x11, 0x00, 0x00, 0x00}), make({0x02, 0x11, 0x01, 0x01, 0x01})},
+		{range(0x01, 0xFE), concat({make({0xFF}), range(0x01, 0xFE)})},
+		{range(0x00, 0xFE), concat({make({0x01, 0xFF}), range(0x01, 0xFE)})},
+		{range(0x01, 0xFF), concat({make({0xFF}), range(0x01, 0xFE), make({0x02, 0xFF})})},
+		{concat({range(0x02, 0xFF), make({0x00})}),
+			concat({make({0xFF}), range(0x02, 0xFF), make({0x01, 0x01})})},
+		{concat({range(0x03, 0xFF), make({0x00, 0x01})}),
+			concat({make({0xFE}), range(0x03, 0xFF), make({0x02, 0x01})})},
+	};
+
+	void test_encode()
+	{
+		for (const vector& v : vectors)
+		{
+			const std::span<const std::byte> whole = v.decoded;
+			GPICO_CHECK(encode(std::span(&whole, 1)) == v.encoded);
+			GPICO_CHECK(v.encoded.size() <= gpico::cobs::max_encoded_size(v.decoded.size()));
+		}
+	}
+
+	// Every split into three parts, including empty ones, encodes the same
+	void test_encode_parts()
+	{
+		for (const vector& v : vectors)
+		{
+			const std::span<const std::byte> data = v.decoded;
+			for (size_t i = 0; i <= data.size(); ++i)
+			{
+				for (size_t j = i; j <= data.size(); ++j)
+				{
+					const std::span<const std::byte> parts[] = {
+						data.first(i), data.subspan(i, j - i), data.subspan(j),
+					};
+					if (!GPICO_CHECK(encode(parts) == v.encoded))
+						return;
+				}
+			}
+		}
+
+		// Many empty parts around the data
+		const bytes data = range(0x00, 0xFE);
+		const std::span<const std::byte> parts[] = {{}, {}, data, {}, {}};
+		GPICO_CHECK(encode(parts) == vectors[8].encoded);
+	}
+
+	void test_decode()
+	{
+		using status = gpico::cobs::decoder::status;
+		for (const vector& v : vectors)
+		{
+			status last;
+			// Leading delimiters are ignored, as are empty frames
+			bytes stream = concat({make({0x00}), v.encoded, make({0x00})});
+			GPICO_CHECK(decode(stream, 512, last) == v.decoded);
+			GPICO_CHECK(last == status::complete);
+		}
+
+		// Too large for the buffer
+		status last;
+		decode(concat({vectors[7].encoded, make({0x00})}), 253, last);
+		GPICO_CHECK(last == status::error);
+		// Exactly fits
+		GPICO_CHECK(decode(concat({vectors[7].encoded, make({0x00})}), 254, last) == vectors[7].decoded);
+		GPICO_CHECK(last == status::complete);
+
+		// Truncated block
+		decode(make({0x05, 0x11, 0x22, 0x00}), 512, last);
+		GPICO_CHECK(last == status::error);
+
+		// The decoder resynchronizes after an error
+		bytes stream = concat({make({0x05, 0x11, 0x00}), vectors[4].encoded, make({0x00})});
+		GPICO_CHECK(decode(stream, 512, last) == vectors[4].decoded);
+		GPICO_CHECK(last == status::complete);
+	}
+
+	void test_crc32()
+	{
+		auto text = [](std::string_view s) { return std::as_bytes(std::span(s)); };
+
+		GPICO_CHECK(gpico::crc32(text("")) == 0);
+		GPICO_CHECK(gpico::crc32(text("123456789")) == 0xCBF4'3926);
+		GPICO_CHECK(gpico::crc32(text("The quick brown fox jumps over the lazy dog")) == 0x414F'A339);
+		static_assert(gpico::crc32(std::span<const std::byte>()) == 0);
+
+		// Incremental over every split
+		const auto data = text("123456789");
+		for (size_t i = 0; i <= data.size(); ++i)
+			GPICO_CHECK(gpico::crc32(data.subspan(i), gpico::crc32(data.first(i))) == 0xCBF4'3926);
+
+		// Object representation
+		const uint32_t value = 0x3433'3231;
+		GPICO_CHECK(gpico::crc32(value) == gpico::crc32(text("1234")));
+	}
+}
+
+int main()
+{
+	test_encode();
+	test_encode_parts();
+	test_decode();
+	test_crc32();
+	gpico::test::finish();
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// ChaCha20 DRBG and getentropy. The source is included so the block function
+// can be checked against the RFC 8439 vectors.
+
+#include "test.h"
+
+#include "../src/entropy.cpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+
+// A counter, so every run generates the same output
+void get_rand_128(rng_128_t *random)
+{
+	static uint64_t counter = 0;
+	random->r[0] = ++counter;
+	random->r[1] = ~counter;
+}
+
+extern "C" int getentropy(void *buffer, size_t length);
+
+namespace
+{
+	using bytes = std::vector<std::byte>;
+
+	bytes parse(std::string_view hex)
+	{
+		bytes result;
+		for (size_t i = 0; i + 1 < hex.size(); i += 2)
+			result.push_back(std::byte(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+		return result;
+	}
+
+	// RFC 8439 appendix A.1, test vectors 1 to 3, which use an all zero nonce
+	void test_chacha20()
+	{
+		struct vector
+		{
+			gpico::chacha_key key;
+			uint32_t counter;
+			std::string_view block;
+		};
+		const vector vectors[] = {
+			{{}, 0,
+				"76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7"
+				"da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586"},
+			{{}, 1,
+				"9f07e7be5551387a98ba977c732d080dcb0f29a048e3656912c6533e32ee7aed"
+				"29b721769ce64e43d57133b074d839d531ed1f28510afb45ace10a1f4b794d6f"},
+			{{0, 0, 0, 0, 0, 0, 0, 0x0100'0000}, 1,
+				"3aeb5224ecf849929b9d828db1ced4dd832025e8018b8160b82284f3c949aa5a"
+				"8eca00bbb4a73bdad192b5c42f73f2fd4e273644c8b36125a64addeb006c13a0"},
+		};
+
+		for (const vector& v : vectors)
+		{
+			std::array<std::byte, gpico::block_size> block;
+			gpico::chacha20_block(v.key, v.counter, block);
+			GPICO_CHECK(std::ranges::equal(block, parse(v.block)));
+		}
+	}
+
+	// Every length writes exactly the requested bytes. A byte counts as
+	// written if it differs from the fill in at least one of several
+	// requests, each over a different fill
+	void test_lengths()
+	{
+		constexpr size_t guard = 8;
+		constexpr std::byte fills[] = {
+			std::byte{0x00}, std::byte{0xFF}, std::byte{0x55}, std::byte{0xAA},
+		};
+		for (size_t length = 0; length <= 1100; ++length)
+		{
+			std::vector<bool> written(length + 2 * guard);
+			for (std::byte fill : fills)
+			{
+				bytes buffer(written.size(), fill);
+				gpico::get_entropy(std::span(buffer).subspan(guard, length));
+				for (size_t i = 0; i < buffer.size(); ++i)
+				{
+					if (buffer[i] != fill)
+						written[i] = true;
+				}
+			}
+
+			for (size_t i = 0; i < written.size(); ++i)
+			{
+				const bool inside = i >= guard && i < guard + length;
+				if (!GPICO_CHECK(written[i] == inside))
+				{
+					std::fprintf(stderr, "length %zu, offset %zu\n", length, i);
+					return;
+				}
+			}
+		}
+	}
+
+	// Output never repeats, across requests on both sides of the boundary
+	// between buffered and direct generation (224 bytes, the buffer less the
+	// next key), and across reseeds
+	void test_no_repeats()
+	{
+		const size_t sizes[] = {1, 2, 3, 4, 5, 16, 223, 224, 225, 64, 255, 256, 257, 1000};
+		std::set<bytes> seen;
+		size_t total = 0;
+		for (int round = 0; round < 16; ++round)
+		{
+			for (size_t size : sizes)
+			{
+				bytes output(size);
+				gpico::get_entropy(output);
+				total += size;
+				// Compare aligned 8 byte pieces of every output
+				for (size_t i = 0; i + 8 <= output.size(); i += 8)
+				{
+					if (!GPICO_CHECK(seen.emplace(output.begin() + i, output.begin() + i + 8).second))
+						return;
+				}
+			}
+			if (round == 8)
+				gpico::reseed_entropy();
+		}
+		GPICO_CHECK(seen.size() > total / 16);
+	}
+
+	void test_getentropy()
+	{
+		std::array<std::byte, 257> buffer = {};
+		GPICO_CHECK(getentropy(buffer.data(), 0) == 0);
+		GPICO_CHECK(getentropy(buffer.data(), 3) == 0);
+		GPICO_CHECK(getentropy(buffer.data(), 256) == 0);
+
+		// Over the limit fails without touching the buffer
+		buffer.fill(std::byte{0});
+		errno = 0;
+		GPICO_CHECK(getentropy(buffer.data(), 257) == -1);
+		GPICO_CHECK(errno == EIO);
+		GPICO_CHECK(std::ranges::all_of(buffer, [](std::byte b) { return b == std::byte{0}; }));
+	}
+
+	// Bulk generation rate, in requests of the given size. The number only
+	// compares changes on the same machine
+	void test_throughput(size_t total, size_t size)
+	{
+		bytes buffer(size);
+		// Keeps the output observable, so the work can't be optimized out
+		std::byte sum{0};
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t done = 0; done < total; done += size)
+		{
+			gpico::get_entropy(buffer);
+			sum ^= buffer[done / size % size];
+		}
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+
+		const double seconds = std::chrono::duration<double>(elapsed).count();
+		std::printf("throughput, %zu byte requests: %.1f MB/s (%02x)\n",
+			size, total / seconds / 1e6, static_cast<unsigned>(sum));
+	}
+}
+
+int main()
+{
+	test_chacha20();
+	test_lengths();
+	test_no_repeats();
+	test_getentropy();
+	test_throughput(8 * 1024 * 1024, 256);
+	test_throughput(8 * 1024 * 1024, 4096);
+	gpico::test::finish();
+}
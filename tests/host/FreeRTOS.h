@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Host stand-in for the FreeRTOS kernel, just enough of it for gpico's host
+// tests. Tasks are threads, and ticks are milliseconds of the steady clock.
+
+#ifndef GPICO_HOST_FREERTOS_H_
+#define GPICO_HOST_FREERTOS_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) \
+	((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define configMINIMAL_STACK_SIZE 256
+#define configMAX_TASK_NAME_LEN 16
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 3
+#define configNUMBER_OF_CORES 2
+#define configUSE_CORE_AFFINITY 0
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+#define tskNO_AFFINITY ((UBaseType_t)-1)
+
+#define configASSERT(x) assert(x)
+
+#define portCHECK_IF_IN_ISR() 0
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+void gpico_host_enter_critical();
+void gpico_host_exit_critical();
+
+#define taskENTER_CRITICAL() gpico_host_enter_critical()
+#define taskEXIT_CRITICAL() gpico_host_exit_critical()
+
+#endif//GPICO_HOST_FREERTOS_H_
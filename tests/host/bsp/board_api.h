@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_BOARD_API_H_
+#define GPICO_HOST_BOARD_API_H_
+
+#endif//GPICO_HOST_BOARD_API_H_
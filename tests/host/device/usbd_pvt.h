@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_USBD_PVT_H_
+#define GPICO_HOST_USBD_PVT_H_
+
+typedef void (*osal_task_func_t)(void *param);
+
+void usbd_defer_func(osal_task_func_t func, void *param, bool in_isr);
+
+#endif//GPICO_HOST_USBD_PVT_H_
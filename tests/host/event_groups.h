@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_EVENT_GROUPS_H_
+#define GPICO_HOST_EVENT_GROUPS_H_
+
+#include <FreeRTOS.h>
+
+#include <condition_variable>
+#include <mutex>
+
+typedef uint32_t EventBits_t;
+
+struct host_event_group
+{
+	std::mutex lock;
+	std::condition_variable changed;
+	EventBits_t bits;
+};
+
+typedef host_event_group StaticEventGroup_t;
+typedef host_event_group *EventGroupHandle_t;
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *storage);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+	BaseType_t clear, BaseType_t all, TickType_t timeout);
+
+#endif//GPICO_HOST_EVENT_GROUPS_H_
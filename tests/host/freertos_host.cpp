@@ -0,0 +1,451 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Host implementation of the parts of FreeRTOS and the pico-sdk declared by
+// the headers next to this file, on top of std threads.
+
+#include <FreeRTOS.h>
+#include <event_groups.h>
+#include <semphr.h>
+#include <stream_buffer.h>
+#include <task.h>
+
+#include <hardware/sync.h>
+#include <pico/platform.h>
+#include <pico/time.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+struct host_task
+{
+	std::mutex lock;
+	std::condition_variable notified;
+	std::array<uint32_t, configTASK_NOTIFICATION_ARRAY_ENTRIES> notifications = {};
+	char name[configMAX_TASK_NAME_LEN] = {};
+};
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	const clock::time_point boot = clock::now();
+
+	thread_local host_task *current_task = nullptr;
+
+	std::recursive_mutex critical_section;
+
+	std::array<spin_lock_t, 32> spin_locks;
+	std::array<std::atomic_bool, 32> spin_locks_claimed;
+
+	// Runs wait(deadline) with a deadline for a timeout in ticks, or with
+	// none for portMAX_DELAY
+	template<class Lock, class Predicate>
+	bool wait_for(std::condition_variable& cv, Lock& lock, TickType_t timeout,
+		Predicate ready)
+	{
+		if (timeout == portMAX_DELAY)
+		{
+			cv.wait(lock, ready);
+			return true;
+		}
+		return cv.wait_for(lock, std::chrono::milliseconds(timeout), ready);
+	}
+}
+
+void gpico_host_enter_critical()
+{
+	critical_section.lock();
+}
+
+void gpico_host_exit_critical()
+{
+	critical_section.unlock();
+}
+
+void panic(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	va_end(args);
+	std::fputc('\n', stderr);
+	std::abort();
+}
+
+uint64_t time_us_64()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		clock::now() - boot).count();
+}
+
+uint32_t time_us_32()
+{
+	return static_cast<uint32_t>(time_us_64());
+}
+
+// Tasks
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t func, const char *name,
+	uint32_t, void *param, UBaseType_t, StackType_t*, StaticTask_t *tcb)
+{
+	host_task *task = new host_task;
+	std::strncpy(task->name, name, sizeof(task->name) - 1);
+	tcb->task = task;
+	// Tasks run until the test exits
+	std::thread([task, func, param] {
+		current_task = task;
+		func(param);
+	}).detach();
+	return task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+	if (!current_task)
+		current_task = new host_task;
+	return current_task;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+	return (task ? task : xTaskGetCurrentTaskHandle())->name;
+}
+
+BaseType_t xTaskGetSchedulerState()
+{
+	return taskSCHEDULER_RUNNING;
+}
+
+TickType_t xTaskGetTickCount()
+{
+	return static_cast<TickType_t>(time_us_64() / 1000);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskSetTimeOutState(TimeOut_t *timeout)
+{
+	timeout->start = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *remaining)
+{
+	if (*remaining == portMAX_DELAY)
+		return pdFALSE;
+
+	const TickType_t now = xTaskGetTickCount();
+	const TickType_t elapsed = now - timeout->start;
+	if (elapsed >= *remaining)
+	{
+		*remaining = 0;
+		return pdTRUE;
+	}
+	*remaining -= elapsed;
+	timeout->start = now;
+	return pdFALSE;
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index)
+{
+	{
+		std::lock_guard lock(task->lock);
+		++task->notifications[index];
+	}
+	task->notified.notify_all();
+	return pdPASS;
+}
+
+void vTaskNotifyGiveIndexedFromISR(
+	TaskHandle_t task, UBaseType_t index, BaseType_t *woken)
+{
+	xTaskNotifyGiveIndexed(task, index);
+	if (woken)
+		*woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTakeIndexed(
+	UBaseType_t index, BaseType_t clear, TickType_t timeout)
+{
+	host_task *task = xTaskGetCurrentTaskHandle();
+	std::unique_lock lock(task->lock);
+	uint32_t& value = task->notifications[index];
+	wait_for(task->notified, lock, timeout, [&] { return value != 0; });
+	const uint32_t result = value;
+	if (result)
+		value = clear ? 0 : value - 1;
+	return result;
+}
+
+// Semaphores
+
+namespace
+{
+	SemaphoreHandle_t create_semaphore(
+		StaticSemaphore_t *storage, UBaseType_t max, UBaseType_t initial)
+	{
+		storage->count = initial;
+		storage->max = max;
+		storage->owner = nullptr;
+		storage->depth = 0;
+		return storage;
+	}
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *storage)
+{
+	return create_semaphore(storage, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(
+	UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *storage)
+{
+	return create_semaphore(storage, max, initial);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *storage)
+{
+	return create_semaphore(storage, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *storage)
+{
+	return create_semaphore(storage, 1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout)
+{
+	std::unique_lock lock(semaphore->lock);
+	if (!wait_for(semaphore->changed, lock, timeout,
+			[&] { return semaphore->count != 0; }))
+		return pdFALSE;
+	--semaphore->count;
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+	{
+		std::lock_guard lock(semaphore->lock);
+		if (semaphore->count == semaphore->max)
+			return pdFALSE;
+		++semaphore->count;
+	}
+	semaphore->changed.notify_all();
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t timeout)
+{
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	std::unique_lock lock(semaphore->lock);
+	if (semaphore->owner != self)
+	{
+		if (!wait_for(semaphore->changed, lock, timeout,
+				[&] { return semaphore->owner == nullptr; }))
+			return pdFALSE;
+		semaphore->owner = self;
+	}
+	++semaphore->depth;
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore)
+{
+	{
+		std::lock_guard lock(semaphore->lock);
+		if (semaphore->owner != xTaskGetCurrentTaskHandle())
+			return pdFALSE;
+		if (--semaphore->depth)
+			return pdTRUE;
+		semaphore->owner = nullptr;
+	}
+	semaphore->changed.notify_all();
+	return pdTRUE;
+}
+
+// Event groups
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *storage)
+{
+	storage->bits = 0;
+	return storage;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	EventBits_t result;
+	{
+		std::lock_guard lock(group->lock);
+		result = group->bits |= bits;
+	}
+	group->changed.notify_all();
+	return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	std::lock_guard lock(group->lock);
+	const EventBits_t result = group->bits;
+	group->bits &= ~bits;
+	return result;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+	std::lock_guard lock(group->lock);
+	return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+	BaseType_t clear, BaseType_t all, TickType_t timeout)
+{
+	std::unique_lock lock(group->lock);
+	auto ready = [&] {
+		return all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+	};
+	const bool success = wait_for(group->changed, lock, timeout, ready);
+	const EventBits_t result = group->bits;
+	if (success && clear)
+		group->bits &= ~bits;
+	return result;
+}
+
+// Stream buffers
+
+StreamBufferHandle_t xStreamBufferCreateStatic(size_t size, size_t,
+	uint8_t *storage, StaticStreamBuffer_t *buffer)
+{
+	buffer->storage = storage;
+	buffer->size = size;
+	buffer->head = 0;
+	buffer->count = 0;
+	return buffer;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *data,
+	size_t size, TickType_t timeout)
+{
+	size_t sent = 0;
+	{
+		std::unique_lock lock(buffer->lock);
+		wait_for(buffer->changed, lock, timeout,
+			[&] { return buffer->count < buffer->size; });
+		const auto *bytes = static_cast<const uint8_t*>(data);
+		for (; sent < size && buffer->count < buffer->size; ++sent)
+		{
+			buffer->storage[(buffer->head + buffer->count) % buffer->size] = bytes[sent];
+			++buffer->count;
+		}
+	}
+	buffer->changed.notify_all();
+	return sent;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void *data,
+	size_t size, TickType_t timeout)
+{
+	size_t received = 0;
+	{
+		std::unique_lock lock(buffer->lock);
+		wait_for(buffer->changed, lock, timeout,
+			[&] { return buffer->count != 0; });
+		auto *bytes = static_cast<uint8_t*>(data);
+		for (; received < size && buffer->count; ++received)
+		{
+			bytes[received] = buffer->storage[buffer->head];
+			buffer->head = (buffer->head + 1) % buffer->size;
+			--buffer->count;
+		}
+	}
+	buffer->changed.notify_all();
+	return received;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer)
+{
+	std::lock_guard lock(buffer->lock);
+	return buffer->count;
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer)
+{
+	std::lock_guard lock(buffer->lock);
+	return buffer->size - buffer->count;
+}
+
+// Spin locks
+
+uint32_t save_and_disable_interrupts()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return 0;
+}
+
+void restore_interrupts(uint32_t)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+spin_lock_t *spin_lock_instance(unsigned number)
+{
+	return &spin_locks[number];
+}
+
+unsigned spin_lock_get_num(spin_lock_t *lock)
+{
+	return static_cast<unsigned>(lock - spin_locks.data());
+}
+
+int spin_lock_claim_unused(bool required)
+{
+	for (unsigned i = PICO_SPINLOCK_ID_STRIPED_LAST + 1; i < spin_locks.size(); ++i)
+	{
+		if (!spin_locks_claimed[i].exchange(true))
+			return static_cast<int>(i);
+	}
+	assert(!required);
+	return -1;
+}
+
+void spin_lock_unclaim(unsigned number)
+{
+	spin_locks_claimed[number] = false;
+}
+
+bool spin_try_lock_unsafe(spin_lock_t *lock)
+{
+	return !lock->test_and_set(std::memory_order_acquire);
+}
+
+void spin_lock_unsafe_blocking(spin_lock_t *lock)
+{
+	while (lock->test_and_set(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock)
+{
+	const uint32_t status = save_and_disable_interrupts();
+	spin_lock_unsafe_blocking(lock);
+	return status;
+}
+
+void spin_unlock(spin_lock_t *lock, uint32_t status)
+{
+	lock->clear(std::memory_order_release);
+	restore_interrupts(status);
+}
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_HARDWARE_SYNC_H_
+#define GPICO_HOST_HARDWARE_SYNC_H_
+
+#include <pico.h>
+
+#include <atomic>
+
+#define PICO_SPINLOCK_ID_STRIPED_FIRST 16
+#define PICO_SPINLOCK_ID_STRIPED_LAST 23
+
+typedef std::atomic_flag spin_lock_t;
+
+// There are no interrupts on the host, so these only order memory
+uint32_t save_and_disable_interrupts();
+void restore_interrupts(uint32_t status);
+
+spin_lock_t *spin_lock_instance(unsigned number);
+unsigned spin_lock_get_num(spin_lock_t *lock);
+int spin_lock_claim_unused(bool required);
+void spin_lock_unclaim(unsigned number);
+bool spin_try_lock_unsafe(spin_lock_t *lock);
+void spin_lock_unsafe_blocking(spin_lock_t *lock);
+uint32_t spin_lock_blocking(spin_lock_t *lock);
+void spin_unlock(spin_lock_t *lock, uint32_t status);
+
+#endif//GPICO_HOST_HARDWARE_SYNC_H_
@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_PICO_H_
+#define GPICO_HOST_PICO_H_
+
+#include <cstdint>
+
+#define __time_critical_func(func) func
+
+#endif//GPICO_HOST_PICO_H_
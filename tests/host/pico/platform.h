@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_PICO_PLATFORM_H_
+#define GPICO_HOST_PICO_PLATFORM_H_
+
+#include <pico.h>
+
+[[noreturn]] void panic(const char *format, ...);
+
+#endif//GPICO_HOST_PICO_PLATFORM_H_
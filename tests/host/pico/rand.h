@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_PICO_RAND_H_
+#define GPICO_HOST_PICO_RAND_H_
+
+#include <pico.h>
+
+typedef struct
+{
+	uint64_t r[2];
+} rng_128_t;
+
+// Defined by each test, so they control the entropy source
+void get_rand_128(rng_128_t *random);
+
+#endif//GPICO_HOST_PICO_RAND_H_
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_PICO_TIME_H_
+#define GPICO_HOST_PICO_TIME_H_
+
+#include <pico.h>
+
+uint64_t time_us_64();
+uint32_t time_us_32();
+
+#endif//GPICO_HOST_PICO_TIME_H_
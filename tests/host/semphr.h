@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_SEMPHR_H_
+#define GPICO_HOST_SEMPHR_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <condition_variable>
+#include <mutex>
+
+// Semaphores and mutexes share one implementation, like in FreeRTOS
+struct host_semaphore
+{
+	std::mutex lock;
+	std::condition_variable changed;
+	UBaseType_t count;
+	UBaseType_t max;
+	// Recursive mutexes only
+	TaskHandle_t owner;
+	UBaseType_t depth;
+};
+
+typedef host_semaphore StaticSemaphore_t;
+typedef host_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *storage);
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(
+	UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *storage);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *storage);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *storage);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore);
+
+#endif//GPICO_HOST_SEMPHR_H_
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_STREAM_BUFFER_H_
+#define GPICO_HOST_STREAM_BUFFER_H_
+
+#include <FreeRTOS.h>
+
+#include <condition_variable>
+#include <mutex>
+
+struct host_stream_buffer
+{
+	std::mutex lock;
+	std::condition_variable changed;
+	uint8_t *storage;
+	size_t size;
+	size_t head;
+	size_t count;
+};
+
+typedef host_stream_buffer StaticStreamBuffer_t;
+typedef host_stream_buffer *StreamBufferHandle_t;
+
+StreamBufferHandle_t xStreamBufferCreateStatic(size_t size, size_t trigger,
+	uint8_t *storage, StaticStreamBuffer_t *buffer);
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *data,
+	size_t size, TickType_t timeout);
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void *data,
+	size_t size, TickType_t timeout);
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer);
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer);
+
+#endif//GPICO_HOST_STREAM_BUFFER_H_
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_TASK_H_
+#define GPICO_HOST_TASK_H_
+
+#include <FreeRTOS.h>
+
+struct host_task;
+typedef host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef struct
+{
+	TaskHandle_t task;
+} StaticTask_t;
+
+typedef struct
+{
+	TickType_t start;
+} TimeOut_t;
+
+enum
+{
+	taskSCHEDULER_SUSPENDED = 0,
+	taskSCHEDULER_NOT_STARTED = 1,
+	taskSCHEDULER_RUNNING = 2,
+};
+
+// Threads not started through xTaskCreateStatic become tasks the first time
+// they call into the kernel
+TaskHandle_t xTaskCreateStatic(TaskFunction_t func, const char *name,
+	uint32_t stack_words, void *param, UBaseType_t priority,
+	StackType_t *stack, StaticTask_t *tcb);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+const char *pcTaskGetName(TaskHandle_t task);
+BaseType_t xTaskGetSchedulerState();
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+
+void vTaskSetTimeOutState(TimeOut_t *timeout);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *remaining);
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index);
+void vTaskNotifyGiveIndexedFromISR(
+	TaskHandle_t task, UBaseType_t index, BaseType_t *woken);
+uint32_t ulTaskNotifyTakeIndexed(
+	UBaseType_t index, BaseType_t clear, TickType_t timeout);
+
+#endif//GPICO_HOST_TASK_H_
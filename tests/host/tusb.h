@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Host stand-in for the TinyUSB device stack, with a simulated host on the
+// other end of the bus (see tusb_host.h).
+
+#ifndef GPICO_HOST_TUSB_H_
+#define GPICO_HOST_TUSB_H_
+
+#include <tusb_config.h>
+
+#include <cstdint>
+
+bool tusb_init();
+void tud_task_ext(uint32_t timeout_ms, bool in_isr);
+void tud_task();
+
+bool tud_cdc_n_connected(uint8_t itf);
+uint32_t tud_cdc_n_available(uint8_t itf);
+uint32_t tud_cdc_n_read(uint8_t itf, void *buffer, uint32_t size);
+uint32_t tud_cdc_n_write_available(uint8_t itf);
+uint32_t tud_cdc_n_write(uint8_t itf, const void *data, uint32_t size);
+uint32_t tud_cdc_n_write_flush(uint8_t itf);
+
+#endif//GPICO_HOST_TUSB_H_
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_TUSB_CONFIG_H_
+#define GPICO_HOST_TUSB_CONFIG_H_
+
+#define OPT_OS_NONE 1
+#define OPT_OS_FREERTOS 2
+#define CFG_TUSB_OS OPT_OS_FREERTOS
+
+#define CFG_TUD_CDC 1
+#define CFG_TUD_CDC_EP_BUFSIZE 64
+#define CFG_TUD_CDC_RX_BUFSIZE 256
+#define CFG_TUD_CDC_TX_BUFSIZE 256
+
+#endif//GPICO_HOST_TUSB_CONFIG_H_
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#include "tusb_host.h"
+
+#include <tusb.h>
+#include <device/usbd_pvt.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Deferred function, or a bus event if null
+	struct event
+	{
+		osal_task_func_t func;
+		void *param;
+	};
+
+	std::mutex lock;
+	// Signals events for the USB task, and bus activity
+	std::condition_variable device_changed;
+	std::condition_variable bus_changed;
+	std::condition_variable host_changed;
+
+	std::deque<event> queue;
+	uint64_t processed = 0;
+	bool connected = false;
+	bool paused = false;
+	bool flush = false;
+	std::deque<std::byte> rx;
+	std::deque<std::byte> tx;
+	std::deque<std::byte> inbox;
+
+	void post(event e)
+	{
+		queue.push_back(e);
+		device_changed.notify_all();
+	}
+
+	// Sends full packets as soon as there are any, and partial ones when
+	// flushed, like the USB controller does for TinyUSB
+	void bus()
+	{
+		std::unique_lock guard(lock);
+		for (;;)
+		{
+			bus_changed.wait(guard, [] {
+				return !paused && (tx.size() >= CFG_TUD_CDC_EP_BUFSIZE || (flush && !tx.empty()));
+			});
+			const size_t count = std::min<size_t>(tx.size(), CFG_TUD_CDC_EP_BUFSIZE);
+			inbox.insert(inbox.end(), tx.begin(), tx.begin() + count);
+			tx.erase(tx.begin(), tx.begin() + count);
+			if (tx.empty())
+				flush = false;
+			post({nullptr, nullptr});
+			host_changed.notify_all();
+		}
+	}
+}
+
+namespace usb_host
+{
+	void connect(bool value)
+	{
+		std::lock_guard guard(lock);
+		connected = value;
+		post({nullptr, nullptr});
+	}
+
+	void send(std::span<const std::byte> data)
+	{
+		std::lock_guard guard(lock);
+		rx.insert(rx.end(), data.begin(), data.end());
+		post({nullptr, nullptr});
+	}
+
+	size_t receive(std::span<std::byte> buffer, std::chrono::milliseconds timeout)
+	{
+		std::unique_lock guard(lock);
+		host_changed.wait_for(guard, timeout, [] { return !inbox.empty(); });
+		const size_t count = std::min(buffer.size(), inbox.size());
+		std::copy_n(inbox.begin(), count, buffer.begin());
+		inbox.erase(inbox.begin(), inbox.begin() + count);
+		return count;
+	}
+
+	void pause(bool value)
+	{
+		std::lock_guard guard(lock);
+		paused = value;
+		bus_changed.notify_all();
+	}
+
+	uint64_t events()
+	{
+		std::lock_guard guard(lock);
+		return processed;
+	}
+}
+
+bool tusb_init()
+{
+	std::thread(bus).detach();
+	return true;
+}
+
+void tud_task_ext(uint32_t timeout_ms, bool)
+{
+	std::vector<event> events;
+	{
+		std::unique_lock guard(lock);
+		auto ready = [] { return !queue.empty(); };
+		if (timeout_ms == UINT32_MAX)
+			device_changed.wait(guard, ready);
+		else
+			device_changed.wait_for(guard, std::chrono::milliseconds(timeout_ms), ready);
+		events.assign(queue.begin(), queue.end());
+		queue.clear();
+		processed += events.size();
+	}
+
+	for (const event& e : events)
+	{
+		if (e.func)
+			e.func(e.param);
+	}
+}
+
+void tud_task()
+{
+	tud_task_ext(0, false);
+}
+
+void usbd_defer_func(osal_task_func_t func, void *param, bool)
+{
+	std::lock_guard guard(lock);
+	post({func, param});
+}
+
+bool tud_cdc_n_connected(uint8_t)
+{
+	std::lock_guard guard(lock);
+	return connected;
+}
+
+uint32_t tud_cdc_n_available(uint8_t)
+{
+	std::lock_guard guard(lock);
+	return static_cast<uint32_t>(rx.size());
+}
+
+uint32_t tud_cdc_n_read(uint8_t, void *buffer, uint32_t size)
+{
+	std::lock_guard guard(lock);
+	const size_t count = std::min<size_t>(size, rx.size());
+	std::copy_n(rx.begin(), count, static_cast<std::byte*>(buffer));
+	rx.erase(rx.begin(), rx.begin() + count);
+	return static_cast<uint32_t>(count);
+}
+
+uint32_t tud_cdc_n_write_available(uint8_t)
+{
+	std::lock_guard guard(lock);
+	return static_cast<uint32_t>(CFG_TUD_CDC_TX_BUFSIZE - tx.size());
+}
+
+uint32_t tud_cdc_n_write(uint8_t, const void *data, uint32_t size)
+{
+	std::lock_guard guard(lock);
+	const size_t count = std::min<size_t>(size, CFG_TUD_CDC_TX_BUFSIZE - tx.size());
+	const auto *bytes = static_cast<const std::byte*>(data);
+	tx.insert(tx.end(), bytes, bytes + count);
+	bus_changed.notify_all();
+	return static_cast<uint32_t>(count);
+}
+
+uint32_t tud_cdc_n_write_flush(uint8_t)
+{
+	std::lock_guard guard(lock);
+	flush = true;
+	bus_changed.notify_all();
+	return static_cast<uint32_t>(tx.size());
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+#ifndef GPICO_HOST_TUSB_HOST_H_
+#define GPICO_HOST_TUSB_HOST_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/** Simulated USB host on the other end of the TinyUSB stand-in, for CDC
+ *  interface 0.
+ *
+ * Like the real bus, it moves a packet at a time from the device's TinyUSB
+ * transmit FIFO to the host, posting a transfer complete event to the USB
+ * task after each one.
+ */
+namespace usb_host
+{
+	/** Opens or closes the port, which the device sees as DTR.
+	 */
+	void connect(bool connected);
+
+	/** Sends data to the device.
+	 */
+	void send(std::span<const std::byte> data);
+
+	/** Receives data sent by the device, waiting up to timeout for the first
+	 *  byte.
+	 *
+	 * @returns The number of bytes received.
+	 */
+	size_t receive(std::span<std::byte> buffer, std::chrono::milliseconds timeout);
+
+	/** Stops or resumes reading from the device, like a host application
+	 *  that keeps the port open but doesn't read it.
+	 */
+	void pause(bool paused);
+
+	/** Returns the number of events the USB task has processed.
+	 */
+	uint64_t events();
+}
+
+#endif//GPICO_HOST_TUSB_HOST_H_
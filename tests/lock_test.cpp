@@ -0,0 +1,421 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// gpico::unique_lock, shared_mutex and condition_variable, with threads
+// standing in for tasks.
+
+#include "test.h"
+
+#include <gpico/lock.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using namespace std::chrono_literals;
+	using clock = std::chrono::steady_clock;
+
+	// Counts calls, to check what unique_lock does to the lock it owns
+	struct counting_lock
+	{
+		int locks = 0;
+		int unlocks = 0;
+
+		void lock()
+		{
+			++locks;
+		}
+
+		bool try_lock()
+		{
+			++locks;
+			return true;
+		}
+
+		void unlock()
+		{
+			++unlocks;
+		}
+
+		bool held() const
+		{
+			return locks > unlocks;
+		}
+	};
+
+	// Waits up to 2 s for pred to return true
+	template<class Predicate>
+	bool eventually(Predicate pred)
+	{
+		const auto deadline = clock::now() + 2s;
+		while (!pred())
+		{
+			if (clock::now() > deadline)
+				return false;
+			std::this_thread::sleep_for(100us);
+		}
+		return true;
+	}
+
+	void test_unique_lock()
+	{
+		counting_lock a, b;
+
+		// Moving transfers ownership, only the new owner unlocks
+		{
+			gpico::unique_lock<counting_lock> first(a);
+			gpico::unique_lock<counting_lock> second(std::move(first));
+			GPICO_CHECK(!first.owns_lock() && !first.mutex());
+			GPICO_CHECK(second.owns_lock() && second.mutex() == &a);
+		}
+		GPICO_CHECK(a.locks == 1 && a.unlocks == 1);
+
+		// Move assignment unlocks the lock owned before
+		{
+			gpico::unique_lock<counting_lock> first(a);
+			gpico::unique_lock<counting_lock> second(b);
+			second = std::move(first);
+			GPICO_CHECK(!b.held() && a.held());
+			GPICO_CHECK(second.mutex() == &a && !first.owns_lock());
+			// Self-assignment keeps the lock
+			auto& self = second;
+			second = std::move(self);
+			GPICO_CHECK(second.owns_lock() && a.held());
+		}
+		GPICO_CHECK(!a.held() && a.locks == 2);
+
+		// Assigning a mutex switches to it
+		{
+			gpico::unique_lock<counting_lock> lock(a);
+			lock = b;
+			GPICO_CHECK(!a.held() && b.held() && lock.mutex() == &b);
+		}
+		GPICO_CHECK(!b.held());
+
+		// Unlocking early is not undone by the destructor
+		{
+			gpico::unique_lock<counting_lock> lock(a);
+			lock.unlock();
+			GPICO_CHECK(!lock.owns_lock() && !a.held());
+			lock.lock();
+			GPICO_CHECK(lock && a.held());
+			lock.unlock();
+		}
+		GPICO_CHECK(a.locks == a.unlocks);
+
+		// Released locks are left locked
+		{
+			gpico::unique_lock<counting_lock> lock(a);
+			GPICO_CHECK(lock.release() == &a);
+			GPICO_CHECK(!lock.owns_lock() && !lock.mutex());
+		}
+		GPICO_CHECK(a.held());
+		a.unlock();
+	}
+
+	// A real mutex handed between threads with unique_lock excludes others
+	void test_unique_lock_mutex()
+	{
+		gpico::mutex mutex;
+		uint32_t counter = 0;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&] {
+				for (int j = 0; j < 20'000; ++j)
+				{
+					gpico::unique_lock<gpico::mutex> lock(mutex);
+					gpico::unique_lock<gpico::mutex> moved(std::move(lock));
+					++counter;
+					if (j % 2)
+						moved.unlock();
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		GPICO_CHECK(counter == 4 * 20'000);
+		GPICO_CHECK(mutex.try_lock());
+		mutex.unlock();
+	}
+
+	// Several readers hold the mutex at once, and a writer excludes them
+	void test_shared_readers()
+	{
+		gpico::shared_mutex mutex;
+		constexpr int readers = 4;
+		std::atomic_int inside = 0;
+		std::atomic_bool all_inside = false;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < readers; ++i)
+		{
+			threads.emplace_back([&] {
+				mutex.lock_shared();
+				++inside;
+				// Only returns true if every reader got in at the same time
+				if (eventually([&] { return inside == readers; }))
+					all_inside = true;
+				GPICO_CHECK(!mutex.try_lock());
+				eventually([&] { return all_inside.load(); });
+				mutex.unlock_shared();
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		GPICO_CHECK(all_inside);
+		GPICO_CHECK(mutex.try_lock());
+		GPICO_CHECK(!mutex.try_lock_shared());
+		mutex.unlock();
+		GPICO_CHECK(mutex.try_lock_shared());
+		GPICO_CHECK(mutex.try_lock_shared());
+		mutex.unlock_shared();
+		mutex.unlock_shared();
+	}
+
+	// A waiting writer holds off readers that come after it
+	void test_shared_writer_preference()
+	{
+		gpico::shared_mutex mutex;
+		std::atomic_int order = 0;
+		int writer_order = 0;
+		int reader_order = 0;
+
+		mutex.lock_shared();
+		std::atomic_bool writer_started = false;
+		std::thread writer([&] {
+			writer_started = true;
+			mutex.lock();
+			writer_order = ++order;
+			std::this_thread::sleep_for(20ms);
+			mutex.unlock();
+		});
+		eventually([&] { return writer_started.load(); });
+		std::this_thread::sleep_for(20ms);
+
+		std::atomic_bool reader_done = false;
+		std::thread reader([&] {
+			mutex.lock_shared();
+			reader_order = ++order;
+			mutex.unlock_shared();
+			reader_done = true;
+		});
+		std::this_thread::sleep_for(20ms);
+		// Neither gets in while the first reader is inside
+		GPICO_CHECK(order == 0 && !reader_done);
+
+		mutex.unlock_shared();
+		writer.join();
+		reader.join();
+		GPICO_CHECK(writer_order == 1);
+		GPICO_CHECK(reader_order == 2);
+	}
+
+	// Writers see consistent state under a stream of readers, and are not
+	// starved by them
+	void test_shared_stress()
+	{
+		gpico::shared_mutex mutex;
+		uint32_t a = 0;
+		uint32_t b = 0;
+		std::atomic_bool stop = false;
+		std::atomic<uint32_t> torn = 0;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 3; ++i)
+		{
+			threads.emplace_back([&] {
+				while (!stop)
+				{
+					mutex.lock_shared();
+					if (a != b)
+						++torn;
+					mutex.unlock_shared();
+				}
+			});
+		}
+		for (int i = 0; i < 2; ++i)
+		{
+			threads.emplace_back([&] {
+				for (int j = 0; j < 5'000; ++j)
+				{
+					mutex.lock();
+					++a;
+					++b;
+					mutex.unlock();
+				}
+			});
+		}
+		// The readers never stop on their own, so the writers must finish
+		// while they run
+		threads[3].join();
+		threads[4].join();
+		stop = true;
+		for (int i = 0; i < 3; ++i)
+			threads[i].join();
+		GPICO_CHECK(torn == 0);
+		GPICO_CHECK(a == 2 * 5'000 && b == a);
+	}
+
+	void test_notify()
+	{
+		gpico::mutex mutex;
+		gpico::condition_variable condition;
+		bool ready = false;
+
+		// notify_one wakes a waiter
+		std::thread waiter([&] {
+			gpico::unique_lock<gpico::mutex> lock(mutex);
+			condition.wait(lock, [&] { return ready; });
+			GPICO_CHECK(lock.owns_lock());
+		});
+		std::this_thread::sleep_for(10ms);
+		{
+			gpico::unique_lock<gpico::mutex> lock(mutex);
+			ready = true;
+		}
+		condition.notify_one();
+		waiter.join();
+
+		// notify_all wakes every waiter
+		constexpr int waiters = 4;
+		int generation = 0;
+		std::atomic_int waiting = 0;
+		std::atomic_int woken = 0;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < waiters; ++i)
+		{
+			threads.emplace_back([&] {
+				gpico::unique_lock<gpico::mutex> lock(mutex);
+				++waiting;
+				condition.wait(lock, [&] { return generation == 1; });
+				++woken;
+			});
+		}
+		eventually([&] { return waiting == waiters; });
+		{
+			gpico::unique_lock<gpico::mutex> lock(mutex);
+			generation = 1;
+		}
+		condition.notify_all();
+		for (auto& thread : threads)
+			thread.join();
+		GPICO_CHECK(woken == waiters);
+
+		// A notification with nobody waiting is not kept for later
+		condition.notify_one();
+		gpico::unique_lock<gpico::mutex> lock(mutex);
+		GPICO_CHECK(!condition.wait_for(lock, 0));
+	}
+
+	void test_timeout()
+	{
+		gpico::mutex mutex;
+		gpico::condition_variable condition;
+		gpico::unique_lock<gpico::mutex> lock(mutex);
+
+		auto start = clock::now();
+		GPICO_CHECK(!condition.wait_for(lock, pdMS_TO_TICKS(20)));
+		GPICO_CHECK(clock::now() - start >= 20ms);
+		GPICO_CHECK(lock.owns_lock());
+
+		// With a predicate, the timeout covers all the wake ups, and the
+		// result is the predicate's
+		start = clock::now();
+		int checks = 0;
+		GPICO_CHECK(!condition.wait_for(lock, pdMS_TO_TICKS(20), [&] { ++checks; return false; }));
+		GPICO_CHECK(clock::now() - start >= 20ms);
+		GPICO_CHECK(checks >= 2);
+		GPICO_CHECK(condition.wait_for(lock, pdMS_TO_TICKS(20), [] { return true; }));
+	}
+
+	// Notifications racing timeouts: a waiter either takes the notification
+	// or stops waiting, so none is left behind for a later waiter, and the
+	// count of waiters stays right
+	void test_notify_timeout_race()
+	{
+		gpico::mutex mutex;
+		gpico::condition_variable condition;
+		constexpr int waiters = 4;
+		constexpr int waits = 1'000;
+		std::atomic_int done = 0;
+		std::atomic<uint32_t> received = 0;
+		std::vector<std::thread> threads;
+		for (int i = 0; i < waiters; ++i)
+		{
+			threads.emplace_back([&] {
+				for (int j = 0; j < waits; ++j)
+				{
+					gpico::unique_lock<gpico::mutex> lock(mutex);
+					if (condition.wait_for(lock, 1))
+						++received;
+				}
+				++done;
+			});
+		}
+		// Spread the notifications around the waiters' timeouts
+		uint32_t notified = 0;
+		for (uint32_t i = 0; done < waiters; ++i, ++notified)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(i * 37 % 1500));
+			condition.notify_one();
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		std::printf("notify/timeout race: %lu of %d waits notified, %lu notifications\n",
+			static_cast<unsigned long>(received.load()), waiters * waits,
+			static_cast<unsigned long>(notified));
+		GPICO_CHECK(received > 0 && received <= notified);
+		// With nobody waiting, a notification is dropped
+		condition.notify_one();
+		gpico::unique_lock<gpico::mutex> lock(mutex);
+		GPICO_CHECK(!condition.wait_for(lock, 0));
+	}
+
+	// The same race made certain: holding the critical section keeps a
+	// waiter that timed out from giving up its place until it is notified
+	void test_notify_after_timeout()
+	{
+		gpico::mutex mutex;
+		gpico::condition_variable condition;
+		bool result = false;
+		std::thread waiter([&] {
+			gpico::unique_lock<gpico::mutex> lock(mutex);
+			result = condition.wait_for(lock, pdMS_TO_TICKS(20));
+		});
+		std::this_thread::sleep_for(10ms);
+		taskENTER_CRITICAL();
+		std::this_thread::sleep_for(30ms);
+		condition.notify_one();
+		taskEXIT_CRITICAL();
+		waiter.join();
+
+		// The waiter took the notification, and none is left over
+		GPICO_CHECK(result);
+		gpico::unique_lock<gpico::mutex> lock(mutex);
+		GPICO_CHECK(!condition.wait_for(lock, 0));
+	}
+}
+
+int main()
+{
+	test_unique_lock();
+	test_unique_lock_mutex();
+	test_shared_readers();
+	test_shared_writer_preference();
+	test_shared_stress();
+	test_notify();
+	test_timeout();
+	test_notify_timeout_race();
+	test_notify_after_timeout();
+	gpico::test::finish();
+}
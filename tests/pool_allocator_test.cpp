@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// gpico's pool allocator, built with GPICO_POOL_ALLOCATOR, so it also serves
+// operator new for the whole test. Checks are on the change of the
+// statistics, as the C++ runtime may hold blocks of its own.
+
+#include "test.h"
+
+#include <gpico/pool_allocator.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Size class each request size is served from when there is room
+	size_t class_of(size_t size)
+	{
+		size_t index = 0;
+		while ((size_t{16} << index) < size)
+			++index;
+		return index;
+	}
+
+	// Allocates blocks of the size until its class is full, returning them
+	std::vector<void*> fill_class(size_t size)
+	{
+		const size_t index = class_of(size);
+		std::vector<void*> result;
+		result.reserve(gpico::pool_blocks[index]);
+		while (gpico::get_pool_stats().classes[index].in_use < gpico::pool_blocks[index])
+			result.push_back(gpico::pool_allocate(size));
+		return result;
+	}
+
+	void free_all(const std::vector<void*>& blocks)
+	{
+		for (void *block : blocks)
+			gpico::pool_free(block);
+	}
+
+	// Every size up to the largest block comes from the smallest class that
+	// fits it, larger ones from malloc
+	void test_class_selection()
+	{
+		for (size_t size : {0, 1, 8, 16, 17, 32, 33, 64, 65, 128, 129, 255, 256, 257, 1000})
+		{
+			const gpico::pool_stats before = gpico::get_pool_stats();
+			void *block = gpico::pool_allocate(size);
+			const gpico::pool_stats after = gpico::get_pool_stats();
+			if (!GPICO_CHECK(block))
+				continue;
+			GPICO_CHECK(reinterpret_cast<uintptr_t>(block) % 8 == 0);
+			std::memset(block, 0xA5, size);
+
+			if (size <= 256)
+			{
+				const size_t index = class_of(std::max<size_t>(size, 1));
+				GPICO_CHECK(after.classes[index].in_use == before.classes[index].in_use + 1);
+				GPICO_CHECK(after.classes[index].allocations ==
+					before.classes[index].allocations + 1);
+				GPICO_CHECK(after.fallback_allocations == before.fallback_allocations);
+			}
+			else
+			{
+				GPICO_CHECK(after.fallback_allocations == before.fallback_allocations + 1);
+			}
+
+			gpico::pool_free(block);
+			const gpico::pool_stats freed = gpico::get_pool_stats();
+			for (size_t i = 0; i < freed.classes.size(); ++i)
+				GPICO_CHECK(freed.classes[i].in_use == before.classes[i].in_use);
+		}
+	}
+
+	// Freed blocks are handed out again, most recently freed first
+	void test_reuse()
+	{
+		void *first = gpico::pool_allocate(40);
+		void *second = gpico::pool_allocate(40);
+		GPICO_CHECK(first && second && first != second);
+		gpico::pool_free(first);
+		gpico::pool_free(second);
+		GPICO_CHECK(gpico::pool_allocate(40) == second);
+		GPICO_CHECK(gpico::pool_allocate(40) == first);
+		gpico::pool_free(first);
+		gpico::pool_free(second);
+		gpico::pool_free(nullptr);
+	}
+
+	// A full class spills over to the next one with room, and the largest
+	// one to malloc, counting a failure in the class that was full
+	void test_spill_over()
+	{
+		const gpico::pool_stats start = gpico::get_pool_stats();
+		const std::vector<void*> smallest = fill_class(16);
+		gpico::pool_stats before = gpico::get_pool_stats();
+		GPICO_CHECK(before.classes[0].high_water == gpico::pool_blocks[0]);
+		void *spilled = gpico::pool_allocate(16);
+		gpico::pool_stats after = gpico::get_pool_stats();
+		GPICO_CHECK(spilled);
+		GPICO_CHECK(after.classes[0].failures == before.classes[0].failures + 1);
+		GPICO_CHECK(after.classes[1].in_use == before.classes[1].in_use + 1);
+		GPICO_CHECK(after.fallback_allocations == before.fallback_allocations);
+
+		// Freeing returns each block to the class it came from
+		gpico::pool_free(spilled);
+		free_all(smallest);
+		after = gpico::get_pool_stats();
+		GPICO_CHECK(after.classes[0].in_use == start.classes[0].in_use);
+		GPICO_CHECK(after.classes[1].in_use == start.classes[1].in_use);
+
+		const std::vector<void*> largest = fill_class(256);
+		before = gpico::get_pool_stats();
+		void *fallback = gpico::pool_allocate(256);
+		after = gpico::get_pool_stats();
+		GPICO_CHECK(fallback);
+		GPICO_CHECK(after.classes[4].failures == before.classes[4].failures + 1);
+		GPICO_CHECK(after.fallback_allocations == before.fallback_allocations + 1);
+		gpico::pool_free(fallback);
+		free_all(largest);
+
+		// The high water marks stay
+		after = gpico::get_pool_stats();
+		GPICO_CHECK(after.classes[4].in_use == start.classes[4].in_use);
+		GPICO_CHECK(after.classes[0].high_water == gpico::pool_blocks[0]);
+		GPICO_CHECK(after.classes[4].high_water == gpico::pool_blocks[4]);
+	}
+
+	// Threads allocating and freeing at once never get the same block, count
+	// every fallback, and leave the pools as they found them. Each fills its
+	// blocks with its own number, and checks it is still there when freeing
+	// them.
+	void test_threads()
+	{
+		struct held_block
+		{
+			std::byte *data;
+			size_t size;
+		};
+
+		constexpr size_t iterations = 200'000;
+		const gpico::pool_stats before = gpico::get_pool_stats();
+		uint32_t errors[4] = {};
+		std::array<std::thread, 4> threads;
+		for (int t = 0; t < 4; ++t)
+		{
+			threads[t] = std::thread([t, &errors] {
+				const std::byte mark{static_cast<uint8_t>(t + 1)};
+				auto release = [&](const held_block& block) {
+					if (!std::ranges::all_of(std::span(block.data, block.size),
+							[&](std::byte b) { return b == mark; }))
+						++errors[t];
+					gpico::pool_free(block.data);
+				};
+
+				std::vector<held_block> held;
+				held.reserve(16);
+				for (size_t i = 0; i < iterations; ++i)
+				{
+					// Mostly the small classes, so the threads contend on
+					// them, and some for malloc, to count
+					const size_t size = i % 64 ? 1 + (i * 37 + t * 11) % 40 : 300;
+					auto data = static_cast<std::byte*>(gpico::pool_allocate(size));
+					if (!data)
+					{
+						++errors[t];
+						continue;
+					}
+					std::memset(data, std::to_integer<int>(mark), size);
+					held.push_back({data, size});
+					if (held.size() > 8 || i % 3 == 0)
+					{
+						release(held.front());
+						held.erase(held.begin());
+					}
+				}
+				for (const held_block& block : held)
+					release(block);
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		GPICO_CHECK(std::ranges::all_of(errors, [](uint32_t e) { return e == 0; }));
+
+		const gpico::pool_stats after = gpico::get_pool_stats();
+		for (size_t i = 0; i < after.classes.size(); ++i)
+			GPICO_CHECK(after.classes[i].in_use == before.classes[i].in_use);
+		GPICO_CHECK(after.fallback_allocations ==
+			before.fallback_allocations + threads.size() * (iterations / 64));
+		GPICO_CHECK(after.fallback_failures == before.fallback_failures);
+	}
+}
+
+int main()
+{
+	test_class_selection();
+	test_reuse();
+	test_spill_over();
+	test_threads();
+	gpico::test::finish();
+}
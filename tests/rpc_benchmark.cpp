@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Throughput and latency of gpico::rpc through the real CDC device and USB
+// task, against the simulated USB host: stream and publish frames sent by the
+// device, and request and response round trips. Every frame is decoded and
+// its CRC checked on the host side. Like usb_benchmark, the numbers only
+// compare changes on the same machine.
+
+#include "rpc_host.h"
+#include "test.h"
+#include "tusb_host.h"
+
+#include <gpico/cdc_device.h>
+#include <gpico/rpc.h>
+#include <gpico/static_task.h>
+#include <gpico/usb.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using namespace gpico::test;
+	using namespace std::chrono_literals;
+	using clock = std::chrono::steady_clock;
+
+	gpico::rpc transport(gpico::cdc);
+	gpico::static_task<1024> rpc_task;
+
+	// Method streaming the number of frames in the request, each of the size
+	// in the request, numbered in their first four bytes
+	constexpr uint8_t stream_method = 0x10;
+
+	struct stream_request
+	{
+		uint32_t frames;
+		uint32_t size;
+	};
+
+	double microseconds(clock::duration d)
+	{
+		return std::chrono::duration<double, std::micro>(d).count();
+	}
+
+	void report(const char *name, size_t size, uint32_t frames, clock::duration elapsed)
+	{
+		const double seconds = std::chrono::duration<double>(elapsed).count();
+		std::printf("%s, %zu byte payloads: %.0f frames/s, %.1f MB/s\n",
+			name, size, frames / seconds, frames * size / seconds / 1e6);
+	}
+
+	// Receives frames of the given kind, numbered from 0, and the payload
+	// size, until frames of them arrived; returns how many were wrong
+	uint32_t receive_numbered(gpico::rpc::kind type, size_t size, uint32_t frames)
+	{
+		uint32_t errors = 0;
+		for (uint32_t i = 0; i < frames; ++i)
+		{
+			auto f = receive_frame();
+			if (!GPICO_CHECK(f))
+				return errors + frames - i;
+			uint32_t number = ~i;
+			if (f->payload.size() >= sizeof(number))
+				std::memcpy(&number, f->payload.data(), sizeof(number));
+			if (f->head.type != type || f->payload.size() != size || number != i)
+				++errors;
+		}
+		return errors;
+	}
+
+	void test_stream(uint32_t frames, uint32_t size)
+	{
+		const stream_request request = {frames, size};
+		const auto start = clock::now();
+		usb_host::send(encode_frame({gpico::rpc::kind::request, stream_method, 1},
+			std::as_bytes(std::span(&request, 1))));
+		const uint32_t errors = receive_numbered(gpico::rpc::kind::stream, size, frames);
+		auto response = receive_frame();
+		const auto elapsed = clock::now() - start;
+		GPICO_CHECK(errors == 0);
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::response);
+		report("stream", size, frames, elapsed);
+	}
+
+	void test_publish(uint32_t frames, size_t size)
+	{
+		std::thread publisher([=] {
+			std::vector<std::byte> data(size);
+			const std::span<const std::byte> part = data;
+			for (uint32_t i = 0; i < frames; ++i)
+			{
+				std::memcpy(data.data(), &i, sizeof(i));
+				if (!transport.publish(gpico::rpc::topic::user, std::span(&part, 1)))
+					return;
+			}
+		});
+
+		const auto start = clock::now();
+		const uint32_t errors = receive_numbered(gpico::rpc::kind::publish, size, frames);
+		const auto elapsed = clock::now() - start;
+		publisher.join();
+		GPICO_CHECK(errors == 0);
+		report("publish", size, frames, elapsed);
+	}
+
+	// Sequential ping round trips, each waiting for the response before the
+	// next request
+	void test_round_trips(uint32_t iterations, size_t size)
+	{
+		const bytes payload(size, std::byte{0x5A});
+		std::vector<clock::duration> times;
+		const auto start = clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			const auto sent = clock::now();
+			auto response = call(gpico::rpc::method::ping, static_cast<uint16_t>(i), payload);
+			times.push_back(clock::now() - sent);
+			if (!GPICO_CHECK(response && response->head.tag == static_cast<uint16_t>(i)
+					&& response->payload == payload))
+				return;
+		}
+		const auto elapsed = clock::now() - start;
+
+		std::ranges::sort(times);
+		const double seconds = std::chrono::duration<double>(elapsed).count();
+		std::printf("round trips, %zu byte payloads: %.0f calls/s, %.1f MB/s, "
+			"median %.0f us, 99th percentile %.0f us\n",
+			size, iterations / seconds, 2.0 * iterations * size / seconds / 1e6,
+			microseconds(times[times.size() / 2]), microseconds(times[times.size() * 99 / 100]));
+	}
+}
+
+int main()
+{
+	transport.register_method(stream_method, [](auto request, auto) -> std::expected<size_t, int> {
+		stream_request args;
+		if (request.size() != sizeof(args))
+			return std::unexpected(EINVAL);
+		std::memcpy(&args, request.data(), sizeof(args));
+		if (args.size < sizeof(uint32_t) || args.size > gpico::rpc::max_payload)
+			return std::unexpected(EINVAL);
+
+		std::vector<std::byte> data(args.size);
+		const std::span<const std::byte> part = data;
+		for (uint32_t i = 0; i < args.frames; ++i)
+		{
+			std::memcpy(data.data(), &i, sizeof(i));
+			if (auto result = transport.stream(std::span(&part, 1)); !result)
+				return std::unexpected(result.error());
+		}
+		return 0;
+	});
+
+	gpico::initialize_usb_task();
+	rpc_task.create([](void*) { transport.serve(); }, "rpc", nullptr, 1);
+	usb_host::connect(true);
+
+	const std::byte topic{gpico::rpc::topic::user};
+	auto response = call(gpico::rpc::method::subscribe, 0, std::span(&topic, 1));
+	if (GPICO_CHECK(response))
+		GPICO_CHECK(response->head.type == gpico::rpc::kind::response);
+
+	for (uint32_t size : {16u, 64u, static_cast<uint32_t>(gpico::rpc::max_payload)})
+	{
+		test_stream(20'000, size);
+		test_publish(20'000, size);
+	}
+	test_round_trips(2'000, 8);
+	test_round_trips(500, gpico::rpc::max_payload);
+	gpico::test::finish();
+}
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Host side of gpico::rpc over the simulated USB host, shared by the RPC
+// tests.
+
+#ifndef GPICO_TESTS_RPC_HOST_H_
+#define GPICO_TESTS_RPC_HOST_H_
+
+#include "test.h"
+#include "tusb_host.h"
+
+#include <gpico/cobs.h>
+#include <gpico/crc.h>
+#include <gpico/rpc.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace gpico::test
+{
+	using bytes = std::vector<std::byte>;
+
+	struct frame
+	{
+		rpc::header head;
+		bytes payload;
+	};
+
+	/** Encodes a frame as the host sends it, delimiter included.
+	 *
+	 * @param[in] corrupt Whether to send a wrong CRC.
+	 */
+	inline bytes encode_frame(rpc::header head, std::span<const std::byte> payload,
+		bool corrupt = false)
+	{
+		uint32_t crc = crc32(payload, crc32(head));
+		if (corrupt)
+			crc ^= 1;
+		const std::span<const std::byte> parts[] = {
+			std::as_bytes(std::span(&head, 1)), payload, std::as_bytes(std::span(&crc, 1)),
+		};
+		bytes result;
+		cobs::encode(parts, [&](std::span<const std::byte> data) {
+			result.insert(result.end(), data.begin(), data.end());
+		});
+		result.push_back(std::byte{0});
+		return result;
+	}
+
+	/** Receives the next frame from the device, checking its CRC, or nothing
+	 *  if none arrives within 2 s.
+	 */
+	inline std::optional<frame> receive_frame()
+	{
+		using namespace std::chrono_literals;
+		static std::array<std::byte, 1024> buffer;
+		static cobs::decoder decoder(buffer);
+		// Bytes read from the host but not decoded yet
+		static std::array<std::byte, 4096> input;
+		static std::span<std::byte> pending;
+
+		for (;;)
+		{
+			if (pending.empty())
+			{
+				const size_t count = usb_host::receive(input, 2s);
+				if (!count)
+					return {};
+				pending = std::span(input).first(count);
+			}
+
+			const std::byte byte = pending.front();
+			pending = pending.subspan(1);
+			if (decoder.put(byte) != cobs::decoder::status::complete)
+				continue;
+			auto data = decoder.frame();
+			if (!GPICO_CHECK(data.size() >= sizeof(rpc::header) + 4))
+				return {};
+			auto contents = data.first(data.size() - 4);
+			uint32_t crc;
+			std::memcpy(&crc, data.data() + contents.size(), sizeof(crc));
+			GPICO_CHECK(crc32(contents) == crc);
+
+			frame result;
+			std::memcpy(&result.head, contents.data(), sizeof(result.head));
+			result.payload.assign(contents.begin() + sizeof(result.head), contents.end());
+			return result;
+		}
+	}
+
+	/** Sends a request, and returns the first frame received after it.
+	 */
+	inline std::optional<frame> call(uint8_t id, uint16_t tag, std::span<const std::byte> payload)
+	{
+		usb_host::send(encode_frame({rpc::kind::request, id, tag}, payload));
+		return receive_frame();
+	}
+}
+
+#endif//GPICO_TESTS_RPC_HOST_H_
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// gpico::rpc loopback, through the real CDC device and USB task, with a
+// simulated USB host sending framed requests.
+
+#include "rpc_host.h"
+#include "test.h"
+#include "tusb_host.h"
+
+#include <gpico/cdc_device.h>
+#include <gpico/cobs.h>
+#include <gpico/crc.h>
+#include <gpico/rpc.h>
+#include <gpico/static_task.h>
+#include <gpico/usb.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	using namespace gpico::test;
+	using namespace std::chrono_literals;
+
+	gpico::rpc transport(gpico::cdc);
+	gpico::static_task<1024> rpc_task;
+
+	int32_t error_of(const gpico::test::frame& f)
+	{
+		int32_t error = 0;
+		if (GPICO_CHECK(f.payload.size() == sizeof(error)))
+			std::memcpy(&error, f.payload.data(), sizeof(error));
+		return error;
+	}
+
+	void test_methods()
+	{
+		const bytes hello = {std::byte{'h'}, std::byte{0}, std::byte{'i'}};
+
+		// Transport method
+		auto response = call(gpico::rpc::method::ping, 1, hello);
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::response);
+			GPICO_CHECK(response->head.id == gpico::rpc::method::ping);
+			GPICO_CHECK(response->head.tag == 1);
+			GPICO_CHECK(response->payload == hello);
+		}
+
+		// Application method, with streams ahead of the response
+		response = call(0x10, 2, hello);
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::stream);
+			GPICO_CHECK(response->head.tag == 2);
+			GPICO_CHECK(response->payload.size() == 600);
+			GPICO_CHECK(std::ranges::all_of(response->payload,
+				[](std::byte b) { return b == std::byte{0}; }));
+		}
+		response = receive_frame();
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::response);
+			GPICO_CHECK(response->head.tag == 2);
+			GPICO_CHECK(std::ranges::equal(response->payload, hello | std::views::reverse));
+		}
+
+		// Handler failure
+		response = call(0x11, 3, {});
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::error);
+			GPICO_CHECK(error_of(*response) == EIO);
+		}
+
+		// Handler claiming a response larger than the buffer
+		response = call(0x12, 4, {});
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(error_of(*response) == EMSGSIZE);
+	}
+
+	void test_errors()
+	{
+		// Unknown method
+		auto response = call(0x42, 5, {});
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::error);
+			GPICO_CHECK(response->head.id == 0x42);
+			GPICO_CHECK(response->head.tag == 5);
+			GPICO_CHECK(error_of(*response) == ENOSYS);
+		}
+
+		// Bad arguments to a transport method
+		response = call(gpico::rpc::method::subscribe, 6, {});
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(error_of(*response) == EINVAL);
+
+		// Frames with a bad CRC, that aren't requests, or that are too short
+		// are dropped without an answer, so the next answer is for the ping
+		const std::byte one{1};
+		usb_host::send(encode_frame({gpico::rpc::kind::request, gpico::rpc::method::ping, 7},
+			std::span(&one, 1), true));
+		usb_host::send(encode_frame({gpico::rpc::kind::response, gpico::rpc::method::ping, 8}, {}));
+		usb_host::send(std::vector{std::byte{2}, std::byte{1}, std::byte{0}});
+		response = call(gpico::rpc::method::ping, 9, std::span(&one, 1));
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(response->head.tag == 9);
+
+		// Frames too large for the receive buffer are dropped too
+		const bytes large(gpico::rpc::max_payload + 1, std::byte{1});
+		usb_host::send(encode_frame({gpico::rpc::kind::request, gpico::rpc::method::ping, 10}, large));
+		response = call(gpico::rpc::method::ping, 11, std::span(&one, 1));
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(response->head.tag == 11);
+	}
+
+	void test_publish()
+	{
+		const std::byte topic{gpico::rpc::topic::user};
+		const std::byte data[] = {std::byte{1}, std::byte{2}};
+		const std::span<const std::byte> part = data;
+
+		// Not subscribed, nothing is sent
+		GPICO_CHECK(transport.publish(gpico::rpc::topic::user, std::span(&part, 1)));
+		auto response = call(gpico::rpc::method::subscribe, 12, std::span(&topic, 1));
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::response);
+
+		GPICO_CHECK(transport.publish(gpico::rpc::topic::user, std::span(&part, 1)));
+		response = receive_frame();
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::publish);
+			GPICO_CHECK(response->head.id == gpico::rpc::topic::user);
+			GPICO_CHECK(std::ranges::equal(response->payload, data));
+		}
+	}
+
+	// Stands in for a syslog, which calls the callback with its lock held
+	struct test_log
+	{
+		std::function<void(std::string_view)> callback;
+
+		template<class Func>
+		void register_push_callback(Func&& func)
+		{
+			callback = std::forward<Func>(func);
+		}
+	};
+
+	void test_forward_log()
+	{
+		test_log log;
+		transport.forward_log(log);
+		const std::byte topic{gpico::rpc::topic::log};
+		auto response = call(gpico::rpc::method::subscribe, 13, std::span(&topic, 1));
+		if (GPICO_CHECK(response))
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::response);
+
+		log.callback("first");
+		response = receive_frame();
+		if (GPICO_CHECK(response))
+		{
+			GPICO_CHECK(response->head.type == gpico::rpc::kind::publish);
+			GPICO_CHECK(response->head.id == gpico::rpc::topic::log);
+			GPICO_CHECK(std::ranges::equal(response->payload,
+				std::as_bytes(std::span(std::string_view("first")))));
+		}
+
+		// A host that stops reading must not block the loggers, the records
+		// that don't fit are dropped instead
+		usb_host::pause(true);
+		const std::string record(100, 'x');
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 100; ++i)
+			log.callback(record);
+		GPICO_CHECK(std::chrono::steady_clock::now() - start < 1s);
+		GPICO_CHECK(transport.dropped_log_records() > 0);
+		GPICO_CHECK(transport.dropped_log_records() < 100);
+
+		// The records that were queued arrive whole once the host reads again
+		usb_host::pause(false);
+		const uint32_t sent = 100 - transport.dropped_log_records();
+		for (uint32_t i = 0; i < sent; ++i)
+		{
+			response = receive_frame();
+			if (!GPICO_CHECK(response))
+				break;
+			GPICO_CHECK(response->payload.size() == record.size());
+		}
+	}
+}
+
+int main()
+{
+	transport.register_method(0x10, [](auto request, auto response) -> std::expected<size_t, int> {
+		const bytes zeros(600);
+		const std::span<const std::byte> part = zeros;
+		if (!transport.stream(std::span(&part, 1)))
+			return std::unexpected(EIO);
+		std::ranges::reverse_copy(request, response.begin());
+		return request.size();
+	});
+	transport.register_method(0x11, [](auto, auto) -> std::expected<size_t, int> {
+		return std::unexpected(EIO);
+	});
+	transport.register_method(0x12, [](auto, auto response) -> std::expected<size_t, int> {
+		return response.size() + 1;
+	});
+	GPICO_CHECK(!transport.register_method(0x10, {}));
+	GPICO_CHECK(!transport.register_method(gpico::rpc::method::ping, {}));
+
+	gpico::initialize_usb_task();
+	rpc_task.create([](void*) { transport.serve(); }, "rpc", nullptr, 1);
+	usb_host::connect(true);
+
+	test_methods();
+	test_errors();
+	test_publish();
+	test_forward_log();
+	gpico::test::finish();
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Minimal checking for gpico's host tests, which are plain executables that
+// ctest runs.
+
+#ifndef GPICO_TEST_H_
+#define GPICO_TEST_H_
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace gpico::test
+{
+	inline int failures = 0;
+
+	inline bool check(bool value, const char *expression, const char *file, int line)
+	{
+		if (!value)
+		{
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+			++failures;
+		}
+		return value;
+	}
+
+	/** Reports the result and exits, without waiting for tasks, which never
+	 *  return.
+	 */
+	[[noreturn]] inline void finish()
+	{
+		if (failures)
+			std::fprintf(stderr, "%d checks failed\n", failures);
+		std::fflush(stdout);
+		std::fflush(stderr);
+		std::_Exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+}
+
+#define GPICO_CHECK(expression) \
+	::gpico::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif//GPICO_TEST_H_
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+// SPDX-FileCopyrightText: Gabriel Marcano, 2026
+/// @file
+
+// Throughput and latency of the CDC device and USB task, against the
+// simulated USB host, which posts an event per packet like the USB interrupt
+// does. Also checks that the USB task sleeps when idle, and that writes
+// larger than the transmit buffer complete. The numbers only compare changes
+// to the USB task on the same machine; the host bus is far faster than USB.
+
+#include "test.h"
+#include "tusb_host.h"
+
+#include <gpico/cdc_device.h>
+#include <gpico/usb.h>
+
+#include <tusb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using namespace std::chrono_literals;
+	using clock = std::chrono::steady_clock;
+
+	using bytes = std::vector<std::byte>;
+
+	std::byte pattern(size_t i)
+	{
+		return std::byte(i * 7 + (i >> 8));
+	}
+
+	double microseconds(clock::duration d)
+	{
+		return std::chrono::duration<double, std::micro>(d).count();
+	}
+
+	// Without writes or bus activity the USB task must block, not poll
+	void test_idle()
+	{
+		std::this_thread::sleep_for(50ms);
+		const uint64_t before = usb_host::events();
+		std::this_thread::sleep_for(200ms);
+		const uint64_t events = usb_host::events() - before;
+		std::printf("idle: %llu events in 200 ms\n", static_cast<unsigned long long>(events));
+		GPICO_CHECK(events == 0);
+	}
+
+	// Writes total bytes in chunks of the given size, and reads them on the
+	// host side, checking every byte
+	void test_throughput(size_t total, size_t chunk)
+	{
+		std::thread writer([=] {
+			bytes data(chunk);
+			for (size_t offset = 0; offset < total; offset += chunk)
+			{
+				const size_t size = std::min(chunk, total - offset);
+				for (size_t i = 0; i < size; ++i)
+					data[i] = pattern(offset + i);
+				gpico::cdc.write(std::span(data).first(size));
+			}
+			gpico::cdc.flush();
+		});
+
+		const uint64_t events = usb_host::events();
+		const auto start = clock::now();
+		bytes buffer(4096);
+		size_t received = 0;
+		size_t errors = 0;
+		while (received < total)
+		{
+			const size_t count = usb_host::receive(buffer, 2s);
+			if (!GPICO_CHECK(count))
+				break;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (buffer[i] != pattern(received + i))
+					++errors;
+			}
+			received += count;
+		}
+		const auto elapsed = clock::now() - start;
+		writer.join();
+		GPICO_CHECK(received == total);
+		GPICO_CHECK(errors == 0);
+
+		const double seconds = std::chrono::duration<double>(elapsed).count();
+		std::printf("throughput, %zu byte writes: %.1f MB/s, %.2f events per packet\n",
+			chunk, total / seconds / 1e6,
+			static_cast<double>(usb_host::events() - events) / (total / CFG_TUD_CDC_EP_BUFSIZE));
+	}
+
+	// Round trips of a short message the device echoes back, sent either
+	// right away with flush(), or by the flush policy
+	void test_latency(bool flush, size_t iterations)
+	{
+		std::thread echo([=] {
+			std::byte buffer[64];
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				const int count = gpico::cdc.read(buffer);
+				if (count <= 0)
+					return;
+				gpico::cdc.write(std::span(buffer).first(count));
+				if (flush)
+					gpico::cdc.flush();
+			}
+		});
+
+		std::vector<clock::duration> times;
+		const bytes message = {std::byte{'p'}, std::byte{'i'}, std::byte{'n'}, std::byte{'g'}};
+		bytes response(message.size());
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			const auto start = clock::now();
+			usb_host::send(message);
+			size_t received = 0;
+			while (received < response.size())
+			{
+				const size_t count = usb_host::receive(std::span(response).subspan(received), 2s);
+				if (!count)
+					break;
+				received += count;
+			}
+			times.push_back(clock::now() - start);
+			if (!GPICO_CHECK(response == message))
+				break;
+		}
+		echo.join();
+
+		std::ranges::sort(times);
+		std::printf("latency, %s: median %.0f us, 99th percentile %.0f us\n",
+			flush ? "flush()" : "flush policy",
+			microseconds(times[times.size() / 2]), microseconds(times[times.size() * 99 / 100]));
+		// Without flush(), the policy's 10 ms deadline sends the data
+		if (!flush)
+			GPICO_CHECK(times[times.size() / 2] >= 10ms);
+	}
+}
+
+int main()
+{
+	gpico::initialize_usb_task();
+	usb_host::connect(true);
+	while (!gpico::cdc.connected())
+		std::this_thread::sleep_for(1ms);
+
+	test_idle();
+	// A single write several times the transmit buffer, which used to hang
+	test_throughput(64 * 1024, 64 * 1024);
+	test_throughput(4 * 1024 * 1024, 512);
+	test_throughput(1024 * 1024, 7);
+	test_latency(true, 1000);
+	test_latency(false, 20);
+	test_idle();
+	gpico::test::finish();
+}
@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+# SPDX-FileCopyrightText: Gabriel Marcano, 2026
+
+"""Host-side client for gpico::rpc, the framed binary transport over CDC.
+
+Can be used as a module, or from the command line to ping the device, to
+print log records as they are published, or to list and fetch files served by
+gpico::file_service, e.g.:
+
+    gpico_rpc.py /dev/ttyACM1 ping
+    gpico_rpc.py /dev/ttyACM1 log
+    gpico_rpc.py /dev/ttyACM1 ls /
+    gpico_rpc.py /dev/ttyACM1 get /log.txt log.txt
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+REQUEST = 0
+RESPONSE = 1
+ERROR = 2
+PUBLISH = 3
+STREAM = 4
+
+PING = 0xF0
+SUBSCRIBE = 0xF1
+UNSUBSCRIBE = 0xF2
+
+TOPIC_LOG = 0
+
+FILE_SERVICE_BASE = 0x10
+FILE_LIST = 0
+FILE_READ = 1
+LFS_TYPE_DIR = 2
+
+_HEADER = struct.Struct('<BBH')
+
+
+def cobs_encode(data):
+    """Returns the COBS encoding of data, without the frame delimiter."""
+    out = bytearray()
+    block = bytearray()
+    full = False
+    for byte in data:
+        full = False
+        if byte == 0:
+            out.append(len(block) + 1)
+            out += block
+            block.clear()
+            continue
+        block.append(byte)
+        if len(block) == 254:
+            out.append(255)
+            out += block
+            block.clear()
+            full = True
+    # A full block at the very end needs no terminating code
+    if not full:
+        out.append(len(block) + 1)
+        out += block
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Returns the data encoded by COBS, or None if it is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 255 and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class RpcError(Exception):
+    """The device answered a request with an errno value."""
+
+    def __init__(self, method, errno):
+        super().__init__(f'method {method:#x} failed with errno {errno}')
+        self.method = method
+        self.errno = errno
+
+
+class Client:
+    """Client of a gpico::rpc transport on a serial port."""
+
+    def __init__(self, port, timeout=1.0):
+        self.serial = serial.Serial(port, timeout=timeout)
+        self.timeout = timeout
+        self._buffer = bytearray()
+        self._tag = 0
+        self.handlers = {}
+
+    def close(self):
+        self.serial.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def send(self, kind, ident, tag, payload=b''):
+        frame = _HEADER.pack(kind, ident, tag) + payload
+        frame += struct.pack('<I', zlib.crc32(frame))
+        self.serial.write(cobs_encode(frame) + b'\0')
+
+    def receive(self, timeout=None):
+        """Returns the next valid frame as (kind, id, tag, payload), or None
+        if none arrives before the timeout."""
+        deadline = time.monotonic() + (self.timeout if timeout is None else timeout)
+        while True:
+            end = self._buffer.find(0)
+            if end >= 0:
+                encoded = bytes(self._buffer[:end])
+                del self._buffer[:end + 1]
+                frame = cobs_decode(encoded)
+                if frame is None or len(frame) < _HEADER.size + 4:
+                    continue
+                contents, crc = frame[:-4], struct.unpack('<I', frame[-4:])[0]
+                if zlib.crc32(contents) != crc:
+                    continue
+                kind, ident, tag = _HEADER.unpack_from(contents)
+                return kind, ident, tag, contents[_HEADER.size:]
+            if time.monotonic() >= deadline:
+                return None
+            self._buffer += self.serial.read(max(1, self.serial.in_waiting))
+
+    def call(self, method, payload=b'', retries=3, on_stream=None):
+        """Calls a method, returning its response payload.
+
+        Stream frames sent for the request are handed to on_stream. Publish
+        frames received while waiting are handed to the handler registered
+        for their topic in self.handlers."""
+        for _ in range(retries):
+            self._tag = (self._tag + 1) & 0xFFFF
+            self.send(REQUEST, method, self._tag, payload)
+            while (frame := self.receive()) is not None:
+                kind, ident, tag, body = frame
+                if kind == PUBLISH:
+                    self._publish(ident, body)
+                elif tag != self._tag or ident != method:
+                    continue
+                elif kind == STREAM:
+                    if on_stream:
+                        on_stream(body)
+                elif kind == ERROR:
+                    raise RpcError(method, struct.unpack('<i', body)[0])
+                else:
+                    return body
+        raise TimeoutError(f'no response to method {method:#x}')
+
+    def subscribe(self, topic, handler):
+        self.handlers[topic] = handler
+        self.call(SUBSCRIBE, bytes([topic]))
+
+    def unsubscribe(self, topic):
+        self.call(UNSUBSCRIBE, bytes([topic]))
+        self.handlers.pop(topic, None)
+
+    def poll(self, timeout=None):
+        """Waits for publish frames, handing them to their handlers."""
+        frame = self.receive(timeout)
+        if frame is not None and frame[0] == PUBLISH:
+            self._publish(frame[1], frame[3])
+
+    def list(self, path, base=FILE_SERVICE_BASE):
+        """Returns the entries of a directory as (name, type, size) tuples."""
+        entries = []
+        while True:
+            body = self.call(base + FILE_LIST,
+                struct.pack('<H', len(entries)) + path.encode())
+            if not body:
+                return entries
+            i = 0
+            while i < len(body):
+                kind, size, length = struct.unpack_from('<BIB', body, i)
+                i += 6
+                entries.append((body[i:i + length].decode(), kind, size))
+                i += length
+
+    def read(self, path, offset=0, length=0, base=FILE_SERVICE_BASE):
+        """Returns the contents of a file, or of part of it."""
+        data = bytearray()
+
+        def chunk(body):
+            position = struct.unpack_from('<I', body)[0] - offset
+            if position != len(data):
+                raise IOError(f'chunk at {position} lost, expected {len(data)}')
+            data.extend(body[4:])
+
+        body = self.call(base + FILE_READ,
+            struct.pack('<II', offset, length) + path.encode(),
+            retries=1, on_stream=chunk)
+        size, crc = struct.unpack('<II', body)
+        if size != len(data) or zlib.crc32(data) != crc:
+            raise IOError(f'transfer of {path} corrupted')
+        return bytes(data)
+
+    def _publish(self, topic, payload):
+        handler = self.handlers.get(topic)
+        if handler:
+            handler(payload)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='serial port of the RPC CDC interface')
+    parser.add_argument('command', choices=['ping', 'log', 'ls', 'get'])
+    parser.add_argument('path', nargs='?', default='/',
+        help='path of the directory or file on the device')
+    parser.add_argument('output', nargs='?',
+        help='where to save the file fetched, stdout if missing')
+    args = parser.parse_args()
+
+    with Client(args.port) as client:
+        if args.command == 'ping':
+            payload = bytes(range(64))
+            start = time.monotonic()
+            assert client.call(PING, payload) == payload
+            print(f'round trip: {(time.monotonic() - start) * 1000:.2f} ms')
+        elif args.command == 'ls':
+            for name, kind, size in client.list(args.path):
+                print(f'{name}/' if kind == LFS_TYPE_DIR else f'{name}\t{size}')
+        elif args.command == 'get':
+            start = time.monotonic()
+            data = client.read(args.path)
+            elapsed = time.monotonic() - start
+            if args.output:
+                with open(args.output, 'wb') as output:
+                    output.write(data)
+            else:
+                sys.stdout.buffer.write(data)
+            print(f'{len(data)} bytes in {elapsed:.2f} s '
+                f'({len(data) / elapsed / 1024:.1f} KiB/s)', file=sys.stderr)
+        else:
+            client.subscribe(TOPIC_LOG,
+                lambda record: print(record.decode(errors='replace')))
+            try:
+                while True:
+                    client.poll()
+            except KeyboardInterrupt:
+                client.unsubscribe(TOPIC_LOG)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
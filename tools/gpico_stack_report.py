@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+# SPDX-FileCopyrightText: Gabriel Marcano, 2026
+
+"""Reports the worst-case stack usage of each function of a build.
+
+Reads the .su files GCC writes with -fstack-usage, for the frame size of each
+function, and the .ci files it writes with -fcallgraph-info=su, for the call
+graph, from the directories given (searched recursively). The worst case of a
+function is its frame plus the worst case of its deepest callee. Functions
+whose worst case cannot be known are flagged:
+
+    dynamic    the frame size depends on run-time values (e.g. alloca)
+    bounded    dynamic, but GCC found a bound, which is used
+    recursive  the function is part of a call cycle, counted once
+    indirect   calls through pointers, which are not followed
+    unknown    calls functions with no stack data (e.g. precompiled ones)
+
+e.g., to list the 20 deepest functions, or the ones of gpico's tasks:
+
+    gpico_stack_report.py build/CMakeFiles/app.dir --top 20
+    gpico_stack_report.py build/CMakeFiles/app.dir --match 'gpico::.*task'
+"""
+
+import argparse
+import os
+import re
+import sys
+
+_SU_LINE = re.compile(r'^(.*):(\d+):(\d+):(.+)\t(\d+)\t(\S+)$')
+_CI_NODE = re.compile(r'node:\s*\{\s*title:\s*"([^"]*)"\s*label:\s*"([^"]*)"')
+_CI_EDGE = re.compile(r'edge:\s*\{\s*sourcename:\s*"([^"]*)"\s*targetname:\s*"([^"]*)"')
+_CI_STACK = re.compile(r'(\d+) bytes \(([^)]*)\)')
+
+INDIRECT = '__indirect_call'
+
+
+class Function:
+    def __init__(self, name, location=''):
+        self.name = name
+        self.location = location
+        self.frame = None
+        self.qualifiers = ''
+        self.callees = set()
+
+
+def read_files(directories):
+    """Returns the functions found, keyed by assembler name where known."""
+    functions = {}
+    frames = {}
+    for directory in directories:
+        for root, _, files in os.walk(directory):
+            for file in files:
+                path = os.path.join(root, file)
+                if file.endswith('.ci'):
+                    read_callgraph(path, functions)
+                elif file.endswith('.su'):
+                    read_stack_usage(path, frames)
+
+    # .su files name functions by their printable name, so they only fill in
+    # what the call graph did not have
+    by_name = {function.name: function for function in functions.values()}
+    for (name, location), (frame, qualifiers) in frames.items():
+        function = by_name.get(name)
+        if function is None:
+            function = functions.setdefault(name, Function(name, location))
+        if function.frame is None:
+            function.frame, function.qualifiers = frame, qualifiers
+    return functions
+
+
+def read_callgraph(path, functions):
+    with open(path, errors='replace') as source:
+        text = source.read()
+    for title, label in _CI_NODE.findall(text):
+        lines = label.split('\\n')
+        function = functions.setdefault(title, Function(lines[0]))
+        if len(lines) > 1 and not function.location:
+            function.location = lines[1]
+        for line in lines[2:]:
+            match = _CI_STACK.match(line)
+            if match:
+                function.frame = int(match.group(1))
+                function.qualifiers = match.group(2)
+    for source, target in _CI_EDGE.findall(text):
+        functions.setdefault(source, Function(source)).callees.add(target)
+
+
+def read_stack_usage(path, frames):
+    with open(path, errors='replace') as source:
+        for line in source:
+            match = _SU_LINE.match(line.rstrip('\n'))
+            if match:
+                file, row, column, name, frame, qualifiers = match.groups()
+                frames[(name, f'{file}:{row}:{column}')] = (int(frame), qualifiers)
+
+
+def worst_cases(functions):
+    """Returns the worst-case stack usage and flags of every function."""
+    results = {}
+    visiting = set()
+
+    def visit(title):
+        if title in results:
+            return results[title]
+        function = functions.get(title)
+        if title == INDIRECT:
+            return 0, {'indirect'}
+        if function is None or function.frame is None:
+            return 0, {'unknown'}
+        if title in visiting:
+            return 0, {'recursive'}
+
+        visiting.add(title)
+        flags = set()
+        if 'dynamic' in function.qualifiers:
+            flags.add('bounded' if 'bounded' in function.qualifiers else 'dynamic')
+        deepest = 0
+        for callee in function.callees:
+            usage, callee_flags = visit(callee)
+            deepest = max(deepest, usage)
+            flags |= callee_flags
+        visiting.discard(title)
+
+        result = function.frame + deepest, flags
+        # Results depending on a cycle still being walked are incomplete
+        if 'recursive' not in flags:
+            results[title] = result
+        return result
+
+    return {title: visit(title) for title, function in functions.items()
+        if function.frame is not None}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('directories', nargs='+',
+        help='directories with the .su and .ci files of the build')
+    parser.add_argument('--match', metavar='REGEX',
+        help='only report functions whose name matches')
+    parser.add_argument('--top', type=int, metavar='N',
+        help='only report the N deepest functions')
+    args = parser.parse_args()
+
+    functions = read_files(args.directories)
+    if not functions:
+        print('no stack usage data found, is -fstack-usage on?', file=sys.stderr)
+        return 1
+
+    rows = []
+    for title, (usage, flags) in worst_cases(functions).items():
+        function = functions[title]
+        if args.match and not re.search(args.match, function.name):
+            continue
+        rows.append((usage, function.frame, function.name, function.location,
+            ','.join(sorted(flags))))
+    rows.sort(key=lambda row: (-row[0], row[2]))
+    if args.top:
+        rows = rows[:args.top]
+
+    print(f'{"worst":>7} {"frame":>6}  function')
+    for usage, frame, name, location, flags in rows:
+        print(f'{usage:>7} {frame:>6}  {name}' +
+            (f' [{flags}]' if flags else '') +
+            (f'  ({location})' if location else ''))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later OR LGPL-2.1-or-later
+# SPDX-FileCopyrightText: Gabriel Marcano, 2026
+
+"""Fetches the scheduler trace of a gpico device and converts it to the
+Chrome trace JSON format, which chrome://tracing and Perfetto open.
+
+The trace is fetched through the method registered with
+gpico::register_trace_method(). The raw dump can be saved, and converted
+later without the device, e.g.:
+
+    gpico_trace.py /dev/ttyACM1 trace.json
+    gpico_trace.py /dev/ttyACM1 trace.json --save dump.bin
+    gpico_trace.py --load dump.bin trace.json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TRACE_METHOD = 0x20
+
+HEADER_RECORD = 0
+TASK_RECORD = 1
+EVENTS_RECORD = 2
+
+SWITCHED_IN = 1
+SWITCHED_OUT = 2
+TASK_READY = 3
+QUEUE_BLOCK_SEND = 4
+QUEUE_BLOCK_RECEIVE = 5
+ISR_ENTER = 6
+ISR_EXIT = 7
+USER = 8
+
+_EVENT = struct.Struct('<II')
+
+
+def fetch(port, method=TRACE_METHOD, clear=False):
+    """Returns the stream frames of a dump, as a list of bytes."""
+    from gpico_rpc import Client
+
+    records = []
+    with Client(port) as client:
+        client.call(method, bytes([int(clear)]), retries=1,
+            on_stream=records.append)
+    return records
+
+
+def save(records, path):
+    with open(path, 'wb') as output:
+        for record in records:
+            output.write(struct.pack('<I', len(record)) + record)
+
+
+def load(path):
+    records = []
+    with open(path, 'rb') as source:
+        data = source.read()
+    i = 0
+    while i < len(data):
+        length = struct.unpack_from('<I', data, i)[0]
+        records.append(data[i + 4:i + 4 + length])
+        i += 4 + length
+    return records
+
+
+def convert(records):
+    """Converts the records of a dump to a Chrome trace dictionary."""
+    timer_hz = 1000000
+    tasks = {}
+    cores = {}
+    for record in records:
+        if record[0] == HEADER_RECORD:
+            timer_hz = struct.unpack_from('<I', record, 4)[0]
+        elif record[0] == TASK_RECORD:
+            handle = struct.unpack_from('<I', record, 4)[0]
+            tasks[handle] = record[8:].decode(errors='replace')
+        elif record[0] == EVENTS_RECORD:
+            core = record[1]
+            lost = struct.unpack_from('<I', record, 4)[0]
+            if lost:
+                print(f'core {core}: {lost} events lost', file=sys.stderr)
+            cores[core] = [_EVENT.unpack_from(record, i)
+                for i in range(8, len(record) - _EVENT.size + 1, _EVENT.size)]
+
+    # Both cores read the same timer, so unwrap their times against the
+    # earliest event of any core, the one the others are shortly after
+    firsts = [events[0][0] for events in cores.values() if events]
+    base = min(firsts, default=0,
+        key=lambda first: max((other - first) % (1 << 32) for other in firsts))
+
+    def task_name(handle):
+        return tasks.get(handle, f'task {handle:#08x}')
+
+    trace = []
+    for core, events in sorted(cores.items()):
+        trace.append({'ph': 'M', 'pid': 0, 'tid': core * 2,
+            'name': 'thread_name', 'args': {'name': f'core {core}'}})
+        trace.append({'ph': 'M', 'pid': 0, 'tid': core * 2 + 1,
+            'name': 'thread_name', 'args': {'name': f'core {core} irq'}})
+
+        # Events are in order, so each one is less than a timer wrap after
+        # the previous one
+        previous, ticks = base, 0
+        running = first_ts = None
+        for time, data in events:
+            ticks += (time - previous) % (1 << 32)
+            previous = time
+            ts = ticks * 1e6 / timer_hz
+            if first_ts is None:
+                first_ts = ts
+            kind, value = data >> 24, data & 0xFFFFFF
+            common = {'pid': 0, 'tid': core * 2, 'ts': ts}
+
+            if kind == SWITCHED_IN:
+                running = (value, ts)
+            elif kind == SWITCHED_OUT:
+                # The first switch out may be of a task switched in before
+                # the oldest event kept
+                start = running[1] if running and running[0] == value \
+                    else first_ts
+                trace.append(dict(common, ph='X', ts=start, dur=ts - start,
+                    name=task_name(value)))
+                running = None
+            elif kind == TASK_READY:
+                trace.append(dict(common, ph='i', s='t',
+                    name=f'ready {task_name(value)}'))
+            elif kind in (QUEUE_BLOCK_SEND, QUEUE_BLOCK_RECEIVE):
+                action = 'send' if kind == QUEUE_BLOCK_SEND else 'receive'
+                trace.append(dict(common, ph='i', s='t',
+                    name=f'block {action}', args={'queue': f'{value:#08x}'}))
+            elif kind in (ISR_ENTER, ISR_EXIT):
+                trace.append(dict(common, tid=core * 2 + 1,
+                    ph='B' if kind == ISR_ENTER else 'E', name=f'irq {value}'))
+            elif kind == USER:
+                trace.append(dict(common, ph='i', s='t', name=f'user {value}'))
+
+        if running:
+            trace.append({'pid': 0, 'tid': core * 2, 'ph': 'B',
+                'ts': running[1], 'name': task_name(running[0])})
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', nargs='?',
+        help='serial port of the RPC CDC interface')
+    parser.add_argument('output', help='where to write the trace JSON')
+    parser.add_argument('--load', metavar='DUMP',
+        help='convert a saved dump instead of fetching one')
+    parser.add_argument('--save', metavar='DUMP',
+        help='also save the raw dump fetched')
+    parser.add_argument('--clear', action='store_true',
+        help='clear the trace buffers after fetching them')
+    parser.add_argument('--method', type=lambda x: int(x, 0),
+        default=TRACE_METHOD, help='method id of the trace dump method')
+    args = parser.parse_args()
+
+    if args.load:
+        records = load(args.load)
+    elif args.port:
+        records = fetch(args.port, args.method, args.clear)
+        if args.save:
+            save(records, args.save)
+    else:
+        parser.error('either a port or --load is needed')
+
+    with open(args.output, 'w') as output:
+        json.dump(convert(records), output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())